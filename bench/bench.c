@@ -0,0 +1,377 @@
+
+#include "hex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                BENCH.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This is the entry point of hex2dec-bench, the benchmark harness
+ *          for the conversion engine. It generates deterministic inputs for
+ *          a number of size classes, converts them with the same converter
+ *          and output buffer the program uses, and prints the results as
+ *          one JSON object per line, so that they can be compared across
+ *          releases.
+ *
+ *          Every size class is run with plain output, and with pretty-
+ *          printed output using a fixed grouping of three digits separated
+ *          by commas, so that the results do not depend on the locales
+ *          installed on the machine.
+ *
+ *          The inputs are hexadecimal numbers converted to decimal, unless
+ *          other bases are given with '--from' and '--to', in which case the
+ *          inputs have the same number of digits in the input base.
+ *
+ *          The peak resident set size is that of the whole process up to the
+ *          end of each run, so the size classes are run from the smallest
+ *          to the largest, and '--case' runs a single class on its own.
+ *
+ *  **************************************************************************/
+
+// Approximate number of input bytes generated for every size class, unless
+// overridden with '--bytes'. Every class has at least MIN_TOKENS inputs.
+
+#ifndef BENCH_BYTES
+#define BENCH_BYTES (4 << 20)
+#endif // BENCH_BYTES
+
+#define MIN_TOKENS 4
+
+// A length of zero stands for the mixed-length token stream.
+struct size_class {
+    const char* name;
+    size_t digits;
+};
+
+static const struct size_class size_classes[] = {
+    { "8",     8 },
+    { "16",    16 },
+    { "32",    32 },
+    { "1K",    1 << 10 },
+    { "1M",    1 << 20 },
+    { "mixed", 0 }
+};
+
+#define SIZE_CLASS_COUNT (sizeof size_classes / sizeof size_classes[0])
+
+// Whether 'name' is one of the size classes, so that a mistyped case fails
+// rather than running nothing at all.
+static int size_class_exists(const char* name) {
+    for (size_t c = 0; c < SIZE_CLASS_COUNT; ++c) {
+        if (strcmp(name, size_classes[c].name) == 0) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+// Deterministic pseudo-random number generator, so that every run converts
+// exactly the same inputs.
+static uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+
+    return *state = x;
+}
+
+// Length of the next token in the mixed stream, which is mostly made up of
+// short numbers, with the occasional long one.
+static size_t mixed_length(uint64_t* state) {
+    uint64_t r = xorshift64(state);
+    uint64_t bucket = r % 100;
+
+    r >>= 8;
+
+    if (bucket < 70) {
+        return 1 + r % 16;
+    } else if (bucket < 90) {
+        return 17 + r % 48;
+    } else if (bucket < 99) {
+        return 65 + r % 960;
+    }
+
+    return 1025 + r % 3072;
+}
+
+// The generated inputs, every one of which is followed by a newline, just
+// as it would be in an input file.
+struct corpus {
+    char* text;
+    size_t size;
+    size_t* offsets;
+    size_t* lengths;
+    size_t count;
+};
+
+static int corpus_generate(struct corpus* corpus, const struct size_class* class, size_t bytes, int radix) {
+    static const char digit_chars[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+    uint64_t state = UINT64_C(0x9E3779B97F4A7C15) ^ (uint64_t) class->digits;
+
+    // The generator stops at whichever comes first, the number of bytes or
+    // the number of inputs, so the text never needs more room than either
+    // allows. Mixed inputs are at most 4096 digits long.
+    size_t estimate = class->digits ? class->digits : 16;
+    size_t capacity = (bytes / (estimate + 1)) + MIN_TOKENS;
+    size_t text_capacity = class->digits ? capacity * (class->digits + 1) : bytes + (MIN_TOKENS + 1) * 4097;
+
+    corpus->text = malloc(text_capacity);
+    corpus->offsets = malloc(capacity * sizeof (size_t));
+    corpus->lengths = malloc(capacity * sizeof (size_t));
+    corpus->size = 0;
+    corpus->count = 0;
+
+    if ((corpus->text == NULL) || (corpus->offsets == NULL) || (corpus->lengths == NULL)) {
+        fprintf(stderr, "[Error] Failed to allocate the benchmark inputs\n");
+        return FAILURE;
+    }
+
+    while ((corpus->count < capacity) && ((corpus->size < bytes) || (corpus->count < MIN_TOKENS))) {
+        size_t len = class->digits ? class->digits : mixed_length(&state);
+        char* p = corpus->text + corpus->size;
+
+        for (size_t i = 0; i < len; ++i) {
+            p[i] = digit_chars[xorshift64(&state) % (uint64_t) radix];
+        }
+
+        // Keep the number of digits exact, without leading zeros.
+        if (p[0] == '0') {
+            p[0] = '1';
+        }
+
+        p[len] = '\n';
+
+        corpus->offsets[corpus->count] = corpus->size;
+        corpus->lengths[corpus->count] = len;
+        corpus->count += 1;
+        corpus->size += len + 1;
+    }
+
+    return SUCCESS;
+}
+
+static void corpus_free(struct corpus* corpus) {
+    free(corpus->text);
+    free(corpus->offsets);
+    free(corpus->lengths);
+}
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * UINT64_C(1000000000) + (uint64_t) ts.tv_nsec;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*) a;
+    uint64_t y = *(const uint64_t*) b;
+
+    return (x > y) - (x < y);
+}
+
+static uint64_t percentile(const uint64_t* sorted, size_t count, unsigned p) {
+    size_t index = (count * p) / 100;
+
+    return sorted[(index < count) ? index : count - 1];
+}
+
+// Convert every input in the corpus once, timing each conversion on its own,
+// and print the results.
+static int bench_run(const char* name, const struct corpus* corpus, const struct grouping* grouping, int out_fd, size_t threads, const struct base* from, const struct base* to) {
+    struct output out;
+
+    if (output_init(&out, out_fd, 0, FALSE) == FAILURE) {
+        return FAILURE;
+    }
+
+    struct converter conv;
+    converter_init(&conv);
+
+    conv.from = from;
+    conv.to = to;
+    conv.out = &out;
+    conv.grouping = grouping;
+    conv.pretty_print = (grouping != NULL);
+    conv.threads = threads;
+
+    uint64_t* latencies = malloc(corpus->count * sizeof (uint64_t));
+
+    if (latencies == NULL) {
+        fprintf(stderr, "[Error] Failed to allocate the latency samples\n");
+        converter_clear(&conv);
+        output_free(&out);
+        return FAILURE;
+    }
+
+    // Convert the first input once beforehand, so that the buffers and the
+    // power cache are already warm.
+    convert_token(&conv, corpus->text + corpus->offsets[0], corpus->lengths[0]);
+    output_flush(&out);
+
+    int result = SUCCESS;
+    uint64_t start = now_ns();
+
+    for (size_t i = 0; i < corpus->count; ++i) {
+        uint64_t before = now_ns();
+
+        if (convert_token(&conv, corpus->text + corpus->offsets[i], corpus->lengths[i]) == FAILURE) {
+            result = FAILURE;
+            break;
+        }
+
+        latencies[i] = now_ns() - before;
+    }
+
+    if (output_flush(&out) == FAILURE) {
+        result = FAILURE;
+    }
+
+    uint64_t elapsed = now_ns() - start;
+
+    if (result == SUCCESS) {
+        qsort(latencies, corpus->count, sizeof (uint64_t), compare_u64);
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+
+        double seconds = (double) elapsed / 1e9;
+
+        printf("{\"case\":\"%s\",\"mode\":\"%s\",\"from\":%d,\"to\":%d,\"threads\":%zu,\"inputs\":%zu,\"bytes\":%zu,"
+               "\"seconds\":%.6f,\"conversions_per_second\":%.1f,\"bytes_per_second\":%.1f,"
+               "\"p50_ns\":%" PRIu64 ",\"p90_ns\":%" PRIu64 ",\"p99_ns\":%" PRIu64 ",\"max_ns\":%" PRIu64 ","
+               "\"peak_rss_kb\":%ld}\n",
+               name, grouping ? "pretty" : "plain", from->radix, to->radix, threads, corpus->count, corpus->size,
+               seconds, (double) corpus->count / seconds, (double) corpus->size / seconds,
+               percentile(latencies, corpus->count, 50), percentile(latencies, corpus->count, 90),
+               percentile(latencies, corpus->count, 99), latencies[corpus->count - 1],
+               usage.ru_maxrss);
+
+        fflush(stdout);
+    } else {
+        fprintf(stderr, "[Error] Benchmark failed: %s\n", name);
+    }
+
+    free(latencies);
+    converter_clear(&conv);
+    output_free(&out);
+
+    return result;
+}
+
+static void print_usage(void) {
+    printf("Usage: hex2dec-bench [OPTIONS]\n\n");
+    printf("    -h, --help        Print this help menu and exit\n");
+    printf("        --case=NAME   Only run the size class NAME (8, 16, 32, 1K, 1M, or mixed)\n");
+    printf("        --bytes=N     Generate about N bytes of input per size class\n");
+    printf("        --threads=N   Split giant numbers between N threads (default: 1)\n");
+    printf("        --from=BASE   Convert numbers in BASE, from 2 to 36 (default: 16)\n");
+    printf("        --to=BASE     Convert the numbers to BASE, from 2 to 36 (default: 10)\n\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* only = NULL;
+    size_t bytes = BENCH_BYTES;
+    size_t threads = 1;
+    const struct base* from = base_info(16);
+    const struct base* to = base_info(10);
+
+    for (int i = 1; i < argc; ++i) {
+        if ((strcmp(argv[i], "-h") == 0) || (strcmp(argv[i], "--help") == 0)) {
+            print_usage();
+            return EXIT_SUCCESS;
+        } else if (strncmp(argv[i], "--case=", 7) == 0) {
+            only = argv[i] + 7;
+
+            if (size_class_exists(only) == FALSE) {
+                fprintf(stderr, "[Error] Invalid size class: %s (valid classes are", only);
+
+                for (size_t c = 0; c < SIZE_CLASS_COUNT; ++c) {
+                    fprintf(stderr, "%s %s", (c == 0) ? "" : ",", size_classes[c].name);
+                }
+
+                fprintf(stderr, ")\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strncmp(argv[i], "--bytes=", 8) == 0) {
+            bytes = strtoull(argv[i] + 8, NULL, 10);
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = strtoull(argv[i] + 10, NULL, 10);
+            threads = (threads > 0) ? threads : 1;
+        } else if (strncmp(argv[i], "--from=", 7) == 0) {
+            if ((from = base_info(atoi(argv[i] + 7))) == NULL) {
+                fprintf(stderr, "[Error] Invalid input base: %s\n", argv[i] + 7);
+                return EXIT_FAILURE;
+            }
+        } else if (strncmp(argv[i], "--to=", 5) == 0) {
+            if ((to = base_info(atoi(argv[i] + 5))) == NULL) {
+                fprintf(stderr, "[Error] Invalid output base: %s\n", argv[i] + 5);
+                return EXIT_FAILURE;
+            }
+        } else {
+            fprintf(stderr, "[Error] Invalid option: %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // GMP's memory comes from the same memory functions the program uses.
+    memory_install();
+
+    // The results are written to the null device, so that the whole output
+    // path is measured, without the cost of an actual file or terminal.
+    int out_fd = open("/dev/null", O_WRONLY);
+
+    if (out_fd == -1) {
+        fprintf(stderr, "[Error] Could not open /dev/null (%s)\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    // A fixed grouping, independent of the locales available.
+    struct lconv lc = { 0 };
+    lc.thousands_sep = ",";
+    lc.grouping = "\3";
+
+    struct grouping grouping;
+    grouping_init(&grouping, &lc);
+
+    int status = EXIT_SUCCESS;
+
+    for (size_t c = 0; c < SIZE_CLASS_COUNT; ++c) {
+        const struct size_class* class = &size_classes[c];
+
+        if (only && (strcmp(only, class->name) != 0)) {
+            continue;
+        }
+
+        struct corpus corpus;
+
+        if (corpus_generate(&corpus, class, bytes, from->radix) == FAILURE) {
+            corpus_free(&corpus);
+            status = EXIT_FAILURE;
+            break;
+        }
+
+        if ((bench_run(class->name, &corpus, NULL, out_fd, threads, from, to) == FAILURE)
+            || (bench_run(class->name, &corpus, &grouping, out_fd, threads, from, to) == FAILURE)) {
+            status = EXIT_FAILURE;
+        }
+
+        corpus_free(&corpus);
+    }
+
+    close(out_fd);
+
+    return status;
+}
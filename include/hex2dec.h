@@ -17,6 +17,17 @@
 #include <wchar.h>
 #include <wctype.h>
 #include <limits.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <pthread.h>
 
 #include <gmp.h>
 
@@ -28,5 +39,560 @@ enum { FALSE, TRUE };
 enum { SUCCESS, FAILURE };
 #endif // SUCCESS || FAILURE
 
+/** Hexadecimal validation and decoding kernel.
+ *
+ *  The 'scan' function returns the offset of the first character in 'str'
+ *  that is not a hexadecimal digit, or 'len' if they all are. The 'decode'
+ *  function converts each pair of digits in 'str' into a byte in 'out', most
+ *  significant digit first, and returns the offset of the first invalid
+ *  character, or 'len' if there is none. The length passed to 'decode' must
+ *  be even.
+ *
+ */
+struct hex_kernel {
+    const char* name;
+    size_t (*scan)(const char* str, size_t len);
+    size_t (*decode)(const char* str, size_t len, unsigned char* out);
+};
+
+/** Get the fastest decoding kernel supported by the processor.
+ *
+ */
+const struct hex_kernel* hex_kernel(void);
+
+/** Get the value of a hexadecimal digit, or -1 if it is not one.
+ *
+ */
+int hex_value(char c);
+
+/** Numeral bases.
+ *
+ *  Every base from 2 to 36 is supported, with the digits 0 to 9 followed by
+ *  the letters A to Z, in either case. The description of every base is
+ *  fixed at compile time: 'bits' is the number of bits per digit of the
+ *  bases that are powers of two, and zero for every other base, 'shift' is
+ *  the exponent of the largest power of two dividing the base, and
+ *  'chunk_digits' is the number of digits in a 64-bit chunk, the value of a
+ *  full chunk being 'chunk_base', except for the powers of two.
+ *
+ */
+#define MIN_BASE 2
+#define MAX_BASE 36
+
+struct base {
+    int radix;
+    int bits;
+    int shift;
+    int chunk_digits;
+    uint64_t chunk_base;
+};
+
+/** Get the description of a base, or NULL if it is not supported.
+ *
+ */
+const struct base* base_info(int radix);
+
+/** Get the value of a digit in any base, or -1 if it is not one.
+ *
+ */
+int digit_value(char c);
+
+/** Pipeline statistics.
+ *
+ *  Every thread collecting statistics points 'thread_stats' at its own, and
+ *  the time spent in each stage of the pipeline is attributed by switching
+ *  between the stages with 'stats_stage', which returns the stage that was
+ *  current before, so that it can be restored afterwards. If the thread is
+ *  not collecting statistics, nothing is measured.
+ *
+ *  Once the memory functions are installed, GMP's allocations are counted
+ *  in the statistics of the thread making them.
+ *
+ */
+enum {
+    STAGE_OTHER,
+    STAGE_INPUT,
+    STAGE_DECODE,
+    STAGE_CONVERT,
+    STAGE_FORMAT,
+    STAGE_OUTPUT,
+    STAGE_COUNT
+};
+
+#define STATS_HISTOGRAM_BUCKETS 64
+
+struct stats {
+    uint64_t time[STAGE_COUNT];
+    uint64_t last;
+    int stage;
+
+    uint64_t inputs;
+    uint64_t invalid;
+    uint64_t fast_path;
+    uint64_t input_bytes;
+    uint64_t output_bytes;
+    uint64_t lengths[STATS_HISTOGRAM_BUCKETS];
+
+    uint64_t allocations;
+    uint64_t arena_allocations;
+    uint64_t reallocations;
+    uint64_t frees;
+    uint64_t allocated_bytes;
+};
+
+extern _Thread_local struct stats* thread_stats;
+
+uint64_t stats_now(void);
+void stats_init(struct stats* stats);
+int stats_switch(struct stats* stats, int stage);
+void stats_merge(struct stats* into, const struct stats* from);
+void stats_input(struct stats* stats, size_t len);
+void stats_report(const struct stats* stats, uint64_t elapsed, FILE* stream);
+
+static inline int stats_stage(int stage) {
+    if (thread_stats == NULL) {
+        return stage;
+    }
+
+    return stats_switch(thread_stats, stage);
+}
+
+/** GMP memory functions.
+ *
+ *  Once installed, the memory GMP allocates on a thread between a call to
+ *  'arena_enter' and the next call to 'arena_leave' comes from that thread's
+ *  arena, and it is all reclaimed at once when the scope is left. Nothing
+ *  allocated from the arena may be used after that, so any number holding
+ *  memory from it must be reinitialized first, as 'arena_owns' tells.
+ *
+ *  Memory that must outlive the scope is allocated after suspending the
+ *  arena with 'arena_suspend', and then resuming it with 'arena_resume'.
+ *
+ */
+void memory_install(void);
+void arena_enter(void);
+void arena_leave(void);
+int arena_suspend(void);
+void arena_resume(int active);
+int arena_owns(const void* ptr);
+void arena_free(void);
+
+/** Largest native integer type, used for the fast path that bypasses GMP.
+ *
+ *  FAST_PATH_DIGITS is the number of hexadecimal digits it can hold, and
+ *  FAST_PATH_CHUNKS the number of 64-bit chunks of digits in any base.
+ *
+ */
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 fast_uint;
+#define FAST_PATH_DIGITS 32
+#define FAST_PATH_CHUNKS 2
+#else
+typedef uint64_t fast_uint;
+#define FAST_PATH_DIGITS 16
+#define FAST_PATH_CHUNKS 1
+#endif // __SIZEOF_INT128__
+
+/** Little-endian integers, as used by the binary output formats and by the
+ *  server protocol.
+ *
+ *  'store_le' stores the 'count' least significant bytes of 'x', least
+ *  significant first, and 'load_le' loads an integer of 'count' bytes, at
+ *  most eight, stored the same way.
+ *
+ */
+static inline void store_le(unsigned char* bytes, fast_uint x, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        bytes[i] = (unsigned char) x;
+        x >>= 8;
+    }
+}
+
+static inline uint64_t load_le(const unsigned char* bytes, size_t count) {
+    uint64_t x = 0;
+
+    for (size_t i = count; i > 0; --i) {
+        x = (x << 8) | bytes[i - 1];
+    }
+
+    return x;
+}
+
+/** Find the digits of the hexadecimal string 'str' of length 'len'.
+ *
+ *  The optional '0x' prefix and 'h' suffix are accepted, and anything after
+ *  the suffix is ignored. The digits are the range ['start', 'end') of the
+ *  string. On failure, the offset of the first invalid character is stored
+ *  in 'invalid_offset' (if it is not NULL).
+ *
+ */
+int hex_span(const char* str, size_t len, size_t* start, size_t* end, size_t* invalid_offset);
+
+/** Find the digits of the number 'str' of length 'len' in 'base'.
+ *
+ *  This is 'hex_span' for hexadecimal numbers. In binary and octal, the
+ *  optional '0b' and '0o' prefixes are accepted, and there is no suffix in
+ *  any base other than hexadecimal.
+ *
+ */
+int digit_span(const struct base* base, const char* str, size_t len, size_t* start, size_t* end, size_t* invalid_offset);
+
+/** Convert 'count' valid hexadecimal digits to an integer.
+ *
+ *  The native version requires that 'count' is at most FAST_PATH_DIGITS.
+ *  The parallel version splits the digits of a giant number between up to
+ *  'threads' threads.
+ *
+ */
+void hex_to_mpz(mpz_t n, const char* digits, size_t count);
+void hex_to_mpz_parallel(mpz_t n, const char* digits, size_t count, size_t threads);
+fast_uint hex_to_uint(const char* digits, size_t count);
+
+/** Convert 'count' valid digits in 'base' to an integer.
+ *
+ *  The native version requires that 'count' is at most FAST_PATH_CHUNKS
+ *  chunks of digits of the base.
+ *
+ */
+void digits_to_mpz(mpz_t n, const struct base* base, const char* digits, size_t count);
+fast_uint digits_to_uint(const struct base* base, const char* digits, size_t count);
+
+/** Output buffer.
+ *
+ *  Results are assembled in the buffer and written to 'fd' when it fills up,
+ *  or at the end of every line if the output is line-buffered. If 'fd' is -1,
+ *  the output is kept in memory, and the buffer grows as needed instead.
+ *
+ *  Space obtained from 'output_reserve' must be filled and then claimed
+ *  with 'output_commit' before anything else is written.
+ *
+ */
+
+#ifndef OUTPUT_BUFFER_SIZE
+#define OUTPUT_BUFFER_SIZE (1 << 16)
+#endif // OUTPUT_BUFFER_SIZE
+
+struct output {
+    int fd;
+    char* buffer;
+    size_t size;
+    size_t capacity;
+    int line_buffered;
+    int error;
+};
+
+int output_init(struct output* out, int fd, size_t capacity, int line_buffered);
+void output_free(struct output* out);
+int output_flush(struct output* out);
+int output_write(struct output* out, const void* data, size_t len);
+char* output_reserve(struct output* out, size_t len);
+int output_end_line(struct output* out);
+
+static inline void output_commit(struct output* out, size_t len) {
+    out->size += len;
+}
+
+static inline int output_putc(struct output* out, char c) {
+    if (out->size < out->capacity) {
+        out->buffer[out->size++] = c;
+        return SUCCESS;
+    }
+
+    return output_write(out, &c, 1);
+}
+
+/** Digit grouping plan.
+ *
+ *  The plan is resolved once from the locale information. The boundaries
+ *  are the number of digits to the right of each separator, for the groups
+ *  listed explicitly in the locale, after which groups of 'repeat' digits
+ *  repeat indefinitely, unless 'repeat' is zero.
+ *
+ *  The digits passed to the formatter are a run of a number followed by
+ *  'after' more digits, so that a number can be formatted in pieces.
+ *
+ */
+
+#ifndef GROUPING_MAX_GROUPS
+#define GROUPING_MAX_GROUPS 16
+#endif // GROUPING_MAX_GROUPS
+
+struct grouping {
+    char separator[16];
+    size_t separator_length;
+    size_t boundaries[GROUPING_MAX_GROUPS];
+    size_t count;
+    size_t repeat;
+};
+
+void grouping_init(struct grouping* plan, const struct lconv* lc);
+size_t grouping_boundary(const struct grouping* plan, size_t right);
+size_t grouping_length(const struct grouping* plan, size_t count, size_t after);
+char* grouping_format(const struct grouping* plan, const char* digits, size_t count, size_t after, char* dst);
+
+/** Error policies for invalid inputs.
+ *
+ *  An invalid input either stops the conversion, or it is rejected and the
+ *  conversion carries on with the next input, in which case the input is
+ *  skipped, replaced by a placeholder, or replaced by a record of its
+ *  position, which in the text format are INVALID_PLACEHOLDER and a line of
+ *  the form "invalid token=INDEX offset=OFFSET".
+ *
+ */
+enum {
+    ON_ERROR_ABORT,
+    ON_ERROR_SKIP,
+    ON_ERROR_PLACEHOLDER,
+    ON_ERROR_RECORD
+};
+
+#ifndef INVALID_PLACEHOLDER
+#define INVALID_PLACEHOLDER "?"
+#endif // INVALID_PLACEHOLDER
+
+/** Output formats.
+ *
+ *  The text format prints every result on a line of its own, optionally
+ *  pretty-printed. The binary format writes the length of every value in
+ *  bytes as an unsigned 32-bit little-endian integer, followed by the bytes
+ *  of the value, least significant first, and a length of BINARY_INVALID
+ *  marks an invalid input. The u64 format writes every value as exactly
+ *  eight bytes, least significant first, so values that do not fit are
+ *  invalid, and invalid inputs can only be skipped. The NDJSON format prints
+ *  a JSON object on a line of its own for every input, with the input and
+ *  its value in the output base as strings.
+ *
+ */
+enum {
+    FORMAT_TEXT,
+    FORMAT_BINARY,
+    FORMAT_U64,
+    FORMAT_NDJSON
+};
+
+#define BINARY_INVALID UINT32_MAX
+
+/** Reasons an input is invalid: a character that is not a digit in the
+ *  input base, or a value too large for a u64 record.
+ *
+ */
+enum {
+    INVALID_DIGIT = 1,
+    INVALID_RANGE
+};
+
+/** Converter state shared by every input.
+ *
+ *  The arbitrary-precision integer is allocated once and reused for every
+ *  input, and the digit grouping is only set if the user asked for pretty-
+ *  printed output. The inputs are read in base 'from' and printed in base
+ *  'to', and the results are written to 'out'. Giant numbers are parsed and
+ *  printed on up to 'threads' threads, in the output 'format'.
+ *
+ *  Invalid inputs are handled according to the 'on_error' policy, and the
+ *  number of inputs rejected is counted in 'rejected', of which those too
+ *  large for a u64 record are also counted in 'rejected_range'. The reason
+ *  and position of the last invalid input are kept for reporting it, and
+ *  'tokens' is the number of inputs numbered so far.
+ *
+ */
+struct converter {
+    mpz_t n;
+    const struct base* from;
+    const struct base* to;
+    struct output* out;
+    const struct grouping* grouping;
+    int pretty_print;
+    int invalid;
+    size_t threads;
+    int format;
+
+    int on_error;
+    uint64_t tokens;
+    uint64_t rejected;
+    uint64_t rejected_range;
+    uint64_t invalid_index;
+    uint64_t invalid_offset;
+
+    char* digits;
+    size_t digits_capacity;
+
+    mpz_t* powers;
+    mpz_t* quotients;
+    mpz_t* remainders;
+    mpz_t scratch;
+    size_t levels;
+};
+
+void converter_init(struct converter* conv);
+void converter_clear(struct converter* conv);
+
+/** Convert a single input token and print the result.
+ *
+ *  The token does not need to be null-terminated. If the token is not a
+ *  valid number, the 'invalid' flag of the converter is set to INVALID_DIGIT,
+ *  along with the offset of the first invalid character in 'invalid_offset',
+ *  and if its value does not fit in a u64 record, the flag is set to
+ *  INVALID_RANGE. It is up to the caller to report the error with
+ *  'report_invalid_token', which only shows the offset of an invalid digit.
+ *
+ */
+int convert_token(struct converter* conv, const char* token, size_t len);
+void report_invalid_token(int reason, uint64_t index, uint64_t offset);
+
+/** Convert the input token numbered 'index', found 'offset' bytes into its
+ *  input, applying the error policy if it is invalid. This only fails for
+ *  an invalid token if the policy is to abort.
+ *
+ */
+int convert_input(struct converter* conv, const char* token, size_t len, uint64_t index, uint64_t offset);
+
+/** Print the value of 'count' valid digits in the input base in the output
+ *  base, without anything before or after it.
+ *
+ */
+int convert_value(struct converter* conv, const char* digits, size_t count);
+
+/** Print the value of 'x' in the output base.
+ *
+ *  Giant numbers are split recursively by powers of the base, which are
+ *  cached in the converter, and printed in fixed-size chunks as soon as each
+ *  one is ready. When pretty-printing in base 10, the digit groups are
+ *  separated on the fly. With more than one thread, the low halves of the
+ *  largest splits are printed into memory by other threads in the meantime.
+ *  In bases that are powers of two, the digits are simply read off the bits.
+ *
+ */
+int emit_mpz(struct converter* conv, const mpz_t x);
+void emit_uint(struct converter* conv, fast_uint x);
+
+/** Write the value of 'x' in the binary or u64 format. If the value does not
+ *  fit in a u64 record, nothing is written, and the 'invalid' flag of the
+ *  converter is set to INVALID_RANGE.
+ *
+ */
+int emit_binary_mpz(struct converter* conv, const mpz_t x);
+int emit_binary_uint(struct converter* conv, fast_uint x);
+void emit_clear(struct converter* conv);
+
+/** Streaming input reader.
+ *
+ *  The reader splits a file into whitespace-separated tokens. Each token
+ *  points directly into the input buffer, which is the memory mapping of
+ *  the file itself if it could be mapped, and it remains valid only until
+ *  the next token is requested. The 'offset' is the position in the file of
+ *  the start of the buffer.
+ *
+ */
+struct input {
+    const char* name;
+    int fd;
+    char* buffer;
+    size_t capacity;
+    size_t start;
+    size_t end;
+    uint64_t offset;
+    int eof;
+    int error;
+    int mapped;
+};
+
+int input_open(struct input* in, const char* path);
+void input_close(struct input* in);
+int input_next_token(struct input* in, const char** token, size_t* len);
+
+/** Move the unconsumed data in the range ['start', 'end') of the buffer to
+ *  the front, growing the buffer if it is completely full, and then read as
+ *  much as fits after it. This is only ever needed when the input is not
+ *  memory-mapped, and only until 'eof' is set.
+ *
+ */
+int input_fill(struct input* in);
+
+/** Copy the text in the file at 'path', or in standard input if the path
+ *  is a single dash, to the output, converting every hexadecimal number in
+ *  it. The numbers are replaced by their values, or followed by them in
+ *  parentheses in SCAN_APPEND mode. Which words are numbers is described in
+ *  scan.c.
+ *
+ */
+enum {
+    SCAN_REPLACE,
+    SCAN_APPEND
+};
+
+int scan_file(struct converter* conv, const char* path, int mode);
+
+/** Worker pool for converting inputs on multiple threads.
+ *
+ *  Inputs are gathered into batches, which are converted by the worker
+ *  threads into memory, and written to 'out' in the order they were added.
+ *  Every worker has its own converter, with the same output settings as the
+ *  converter passed to 'pool_init'.
+ *
+ *  An input added without copying it must remain valid until 'pool_drain'
+ *  returns. The inputs are numbered in the order they are added, and
+ *  'offset' is the position of each one in its own input. Once any input
+ *  fails, nothing after it is written, and every later call fails, but the
+ *  inputs rejected by the error policy are only counted in 'rejected'.
+ *
+ */
+struct pool {
+    struct output* out;
+    struct batch* batches;
+    struct batch* current;
+    struct worker* workers;
+    size_t thread_count;
+    size_t batch_count;
+
+    // Number of batches handed to the workers, taken by a worker, and
+    // written out, respectively.
+    size_t submitted;
+    size_t taken;
+    size_t written;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    int stopping;
+    int failed;
+
+    // Number of inputs added, and of inputs rejected in the batches written
+    // out so far, along with how many of those were too large for u64.
+    uint64_t tokens;
+    uint64_t rejected;
+    uint64_t rejected_range;
+
+    // Whether the workers collect statistics, which are merged into those of
+    // the thread freeing the pool.
+    int collect_stats;
+};
+
+size_t pool_default_threads(void);
+int pool_init(struct pool* pool, size_t threads, const struct converter* settings, struct output* out);
+int pool_convert(struct pool* pool, const char* token, size_t len, uint64_t offset, int copy);
+int pool_drain(struct pool* pool);
+void pool_free(struct pool* pool);
+
+/** Convert every token in the file at 'path', or in standard input if the
+ *  path is a single dash.
+ *
+ *  If 'pool' is not NULL, the tokens are converted by its workers, and every
+ *  one of them has been written out by the time this returns.
+ *
+ */
+int convert_file(struct converter* conv, struct pool* pool, const char* path);
+
+/** Serve conversion requests until the client closes the stream, or until
+ *  the program is stopped, for the socket at 'path'. SIGINT and SIGTERM stop
+ *  the socket server cleanly, once the request in progress is answered, and
+ *  the socket is removed.
+ *
+ *  The protocol is described in server.c.
+ *
+ */
+int serve_stream(struct converter* conv, int in_fd, int out_fd);
+int serve_socket(struct converter* conv, const char* path);
+
 #endif // hex2dec_H_
 
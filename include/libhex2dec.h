@@ -0,0 +1,103 @@
+
+#ifndef libhex2dec_H_
+#define libhex2dec_H_
+
+#include <stddef.h>
+#include <locale.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/** Only the functions declared here are exported from the shared library.
+ *
+ */
+#if defined(__GNUC__)
+#define HEX2DEC_API __attribute__((visibility("default")))
+#else
+#define HEX2DEC_API
+#endif // __GNUC__
+
+/** Status codes returned by the conversion functions.
+ *
+ */
+enum {
+    HEX2DEC_OK,
+    HEX2DEC_INVALID,
+    HEX2DEC_BUFFER_TOO_SMALL,
+    HEX2DEC_NO_MEMORY
+};
+
+/** Conversion context.
+ *
+ *  The context owns the arbitrary-precision integer, the scratch buffers and
+ *  the resolved digit grouping used for every conversion, all of which are
+ *  reused from one conversion to the next. Once they have grown to fit the
+ *  largest inputs, converting does not allocate any memory of its own.
+ *
+ *  A context may only be used by one thread at a time, but any number of
+ *  contexts may be used concurrently.
+ *
+ */
+typedef struct hex2dec_context hex2dec_context;
+
+/** Create a new context, or return NULL if there is not enough memory.
+ *
+ */
+HEX2DEC_API hex2dec_context* hex2dec_context_new(void);
+
+/** Free a context, along with every buffer it owns.
+ *
+ */
+HEX2DEC_API void hex2dec_context_free(hex2dec_context* ctx);
+
+/** Group the digits of the results as specified by the locale information
+ *  'lc', as returned by 'localeconv'. The grouping is resolved immediately,
+ *  so 'lc' does not need to remain valid. If 'lc' is NULL, the digits are not
+ *  grouped, which is the default.
+ *
+ */
+HEX2DEC_API void hex2dec_context_set_locale(hex2dec_context* ctx, const struct lconv* lc);
+
+/** Split the conversion of giant numbers between up to 'threads' threads.
+ *  The default is a single thread.
+ *
+ */
+HEX2DEC_API void hex2dec_context_set_threads(hex2dec_context* ctx, size_t threads);
+
+/** Read the inputs in base 'from' and write the results in base 'to', both
+ *  of which must be from 2 to 36, or HEX2DEC_INVALID is returned. The
+ *  default is base 16 to base 10. The locale's grouping only ever applies
+ *  to base 10 results, and digits above 9 are written in uppercase.
+ *
+ */
+HEX2DEC_API int hex2dec_context_set_bases(hex2dec_context* ctx, int from, int to);
+
+/** Convert the hexadecimal number 'in', of length 'len', to decimal, or
+ *  between the bases of the context.
+ *
+ *  The input does not need to be null-terminated, and a hexadecimal input
+ *  may have a '0x' prefix or an 'h' suffix. The digits are written to 'out',
+ *  which can hold up to 'cap' bytes, and they are not null-terminated.
+ *
+ *  On success, and if the buffer is too small, the length of the result is
+ *  stored in 'out_len', so that the call may be repeated with a large enough
+ *  buffer. The result is kept in the context until the next call, so if that
+ *  call is for the same input, it only copies the result, without converting
+ *  the number again, unless the settings of the context were changed in the
+ *  meantime. If the input is invalid, the offset of the first invalid
+ *  character is stored instead.
+ *
+ */
+HEX2DEC_API int hex2dec_convert(hex2dec_context* ctx, const char* in, size_t len, char* out, size_t cap, size_t* out_len);
+
+/** Get a description of a status code.
+ *
+ */
+HEX2DEC_API const char* hex2dec_strerror(int status);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // libhex2dec_H_
@@ -0,0 +1,134 @@
+
+#include "hex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                BASE.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This file contains the tables describing every supported base,
+ *          from 2 to 36, along with the validation of numbers written in any
+ *          of them. Hexadecimal numbers are validated by the decoding
+ *          kernels instead, since they are by far the most common inputs.
+ *
+ *          Everything about a base the conversion engine needs is computed
+ *          ahead of time and stored in the tables, so nothing is derived
+ *          from the base while converting a number.
+ *
+ *  **************************************************************************/
+
+// Value of every possible character as a digit plus one, so that the zero-
+// initialized entries mark the characters that are not digits in any base.
+static const unsigned char digit_value_table[UCHAR_MAX + 1] = {
+    ['0'] =  1, ['1'] =  2, ['2'] =  3, ['3'] =  4, ['4'] =  5,
+    ['5'] =  6, ['6'] =  7, ['7'] =  8, ['8'] =  9, ['9'] = 10,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+    ['G'] = 17, ['H'] = 18, ['I'] = 19, ['J'] = 20, ['K'] = 21, ['L'] = 22,
+    ['M'] = 23, ['N'] = 24, ['O'] = 25, ['P'] = 26, ['Q'] = 27, ['R'] = 28,
+    ['S'] = 29, ['T'] = 30, ['U'] = 31, ['V'] = 32, ['W'] = 33, ['X'] = 34,
+    ['Y'] = 35, ['Z'] = 36,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['g'] = 17, ['h'] = 18, ['i'] = 19, ['j'] = 20, ['k'] = 21, ['l'] = 22,
+    ['m'] = 23, ['n'] = 24, ['o'] = 25, ['p'] = 26, ['q'] = 27, ['r'] = 28,
+    ['s'] = 29, ['t'] = 30, ['u'] = 31, ['v'] = 32, ['w'] = 33, ['x'] = 34,
+    ['y'] = 35, ['z'] = 36,
+};
+
+// For every base: the number of bits per digit if it is a power of two, the
+// exponent of the largest power of two dividing it, the number of digits in
+// a 64-bit chunk, and, for the bases that are not powers of two, the value
+// of a full chunk, which is the largest power of the base below 2^64.
+static const struct base bases[MAX_BASE + 1] = {
+    [ 2] = {  2, 1, 1, 64, 0 },
+    [ 3] = {  3, 0, 0, 40, UINT64_C(12157665459056928801) },
+    [ 4] = {  4, 2, 2, 32, 0 },
+    [ 5] = {  5, 0, 0, 27, UINT64_C(7450580596923828125) },
+    [ 6] = {  6, 0, 1, 24, UINT64_C(4738381338321616896) },
+    [ 7] = {  7, 0, 0, 22, UINT64_C(3909821048582988049) },
+    [ 8] = {  8, 3, 3, 21, 0 },
+    [ 9] = {  9, 0, 0, 20, UINT64_C(12157665459056928801) },
+    [10] = { 10, 0, 1, 19, UINT64_C(10000000000000000000) },
+    [11] = { 11, 0, 0, 18, UINT64_C(5559917313492231481) },
+    [12] = { 12, 0, 2, 17, UINT64_C(2218611106740436992) },
+    [13] = { 13, 0, 0, 17, UINT64_C(8650415919381337933) },
+    [14] = { 14, 0, 1, 16, UINT64_C(2177953337809371136) },
+    [15] = { 15, 0, 0, 16, UINT64_C(6568408355712890625) },
+    [16] = { 16, 4, 4, 16, 0 },
+    [17] = { 17, 0, 0, 15, UINT64_C(2862423051509815793) },
+    [18] = { 18, 0, 1, 15, UINT64_C(6746640616477458432) },
+    [19] = { 19, 0, 0, 15, UINT64_C(15181127029874798299) },
+    [20] = { 20, 0, 2, 14, UINT64_C(1638400000000000000) },
+    [21] = { 21, 0, 0, 14, UINT64_C(3243919932521508681) },
+    [22] = { 22, 0, 1, 14, UINT64_C(6221821273427820544) },
+    [23] = { 23, 0, 0, 14, UINT64_C(11592836324538749809) },
+    [24] = { 24, 0, 3, 13, UINT64_C(876488338465357824) },
+    [25] = { 25, 0, 0, 13, UINT64_C(1490116119384765625) },
+    [26] = { 26, 0, 1, 13, UINT64_C(2481152873203736576) },
+    [27] = { 27, 0, 0, 13, UINT64_C(4052555153018976267) },
+    [28] = { 28, 0, 2, 13, UINT64_C(6502111422497947648) },
+    [29] = { 29, 0, 0, 13, UINT64_C(10260628712958602189) },
+    [30] = { 30, 0, 1, 13, UINT64_C(15943230000000000000) },
+    [31] = { 31, 0, 0, 12, UINT64_C(787662783788549761) },
+    [32] = { 32, 5, 5, 12, 0 },
+    [33] = { 33, 0, 0, 12, UINT64_C(1667889514952984961) },
+    [34] = { 34, 0, 1, 12, UINT64_C(2386420683693101056) },
+    [35] = { 35, 0, 0, 12, UINT64_C(3379220508056640625) },
+    [36] = { 36, 0, 2, 12, UINT64_C(4738381338321616896) },
+};
+
+const struct base* base_info(int radix) {
+    if ((radix < MIN_BASE) || (radix > MAX_BASE)) {
+        return NULL;
+    }
+
+    return &bases[radix];
+}
+
+int digit_value(char c) {
+    return digit_value_table[(unsigned char) c] - 1;
+}
+
+int digit_span(const struct base* base, const char* str, size_t len, size_t* start, size_t* end, size_t* invalid_offset) {
+    if (base->radix == 16) {
+        return hex_span(str, len, start, end, invalid_offset);
+    }
+
+    *start = 0;
+
+    // The conventional '0b' and '0o' prefixes are skipped for binary and
+    // octal numbers, but only at the very start of the input, just like the
+    // hexadecimal prefix. There is no suffix in any other base, so anything
+    // that is not a digit is an error.
+    if ((len >= 2) && (str[0] == '0')) {
+        char prefix = (char) tolower((unsigned char) str[1]);
+
+        if (((base->radix == 2) && (prefix == 'b')) || ((base->radix == 8) && (prefix == 'o'))) {
+            *start = 2;
+        }
+    }
+
+    size_t i = *start;
+
+    while ((i < len) && (digit_value_table[(unsigned char) str[i]] != 0) && (digit_value_table[(unsigned char) str[i]] <= base->radix)) {
+        ++i;
+    }
+
+    *end = i;
+
+    if (i < len) {
+        if (invalid_offset) {
+            *invalid_offset = i;
+        }
+
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,395 @@
+
+#include "hex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                CLIENT.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This is the entry point of hex2dec-client, a small client for the
+ *          hex2dec server mode. It sends its arguments, or the whitespace-
+ *          separated numbers in standard input if there are none, to the
+ *          server in a single request, and prints the results in order.
+ *
+ *          The client either connects to a server listening on a socket, or
+ *          starts its own server as a coprocess, talking to it over a pair
+ *          of pipes, which makes it easy to try out the protocol locally.
+ *
+ *  **************************************************************************/
+
+// Program started as the coprocess when no socket is given.
+
+#ifndef DEFAULT_SERVER
+#define DEFAULT_SERVER "hex2dec"
+#endif // DEFAULT_SERVER
+
+static int write_exact(int fd, const void* data, size_t len) {
+    while (len > 0) {
+        ssize_t bytes = write(fd, data, len);
+
+        if (bytes == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            fprintf(stderr, "[Error] Failed to send request (%s)\n", strerror(errno));
+            return FAILURE;
+        }
+
+        data = (const char*) data + bytes;
+        len -= (size_t) bytes;
+    }
+
+    return SUCCESS;
+}
+
+static int read_exact(int fd, void* data, size_t len) {
+    while (len > 0) {
+        ssize_t bytes = read(fd, data, len);
+
+        if (bytes == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            fprintf(stderr, "[Error] Failed to read response (%s)\n", strerror(errno));
+            return FAILURE;
+        }
+
+        if (bytes == 0) {
+            fprintf(stderr, "[Error] Truncated response\n");
+            return FAILURE;
+        }
+
+        data = (char*) data + bytes;
+        len -= (size_t) bytes;
+    }
+
+    return SUCCESS;
+}
+
+// Connect to the server listening on the socket at 'path'.
+static int connect_socket(const char* path, int* in_fd, int* out_fd) {
+    struct sockaddr_un address;
+
+    if (strlen(path) >= sizeof address.sun_path) {
+        fprintf(stderr, "[Error] Socket path too long: %s\n", path);
+        return FAILURE;
+    }
+
+    memset(&address, 0, sizeof address);
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if ((fd == -1) || (connect(fd, (struct sockaddr*) &address, sizeof address) == -1)) {
+        fprintf(stderr, "[Error] Could not connect to socket: %s (%s)\n", path, strerror(errno));
+
+        if (fd != -1) {
+            close(fd);
+        }
+
+        return FAILURE;
+    }
+
+    *in_fd = fd;
+    *out_fd = fd;
+
+    return SUCCESS;
+}
+
+// Start 'program' in server mode, with its standard input and output
+// connected to a pair of pipes.
+static int start_server(const char* program, int pretty_print, int* in_fd, int* out_fd, pid_t* pid) {
+    int requests[2];
+    int responses[2];
+
+    if (pipe(requests) == -1) {
+        fprintf(stderr, "[Error] Could not create pipe (%s)\n", strerror(errno));
+        return FAILURE;
+    }
+
+    if (pipe(responses) == -1) {
+        fprintf(stderr, "[Error] Could not create pipe (%s)\n", strerror(errno));
+        close(requests[0]);
+        close(requests[1]);
+        return FAILURE;
+    }
+
+    *pid = fork();
+
+    if (*pid == -1) {
+        fprintf(stderr, "[Error] Could not start server (%s)\n", strerror(errno));
+        close(requests[0]);
+        close(requests[1]);
+        close(responses[0]);
+        close(responses[1]);
+        return FAILURE;
+    }
+
+    if (*pid == 0) {
+        dup2(requests[0], STDIN_FILENO);
+        dup2(responses[1], STDOUT_FILENO);
+
+        close(requests[0]);
+        close(requests[1]);
+        close(responses[0]);
+        close(responses[1]);
+
+        if (pretty_print) {
+            execlp(program, program, "--server", "--pretty-print", (char*) NULL);
+        } else {
+            execlp(program, program, "--server", (char*) NULL);
+        }
+
+        fprintf(stderr, "[Error] Could not run server: %s (%s)\n", program, strerror(errno));
+        _exit(EXIT_FAILURE);
+    }
+
+    close(requests[0]);
+    close(responses[1]);
+
+    *in_fd = responses[0];
+    *out_fd = requests[1];
+
+    return SUCCESS;
+}
+
+// The request is assembled in a growing buffer.
+struct request {
+    unsigned char* buffer;
+    size_t size;
+    size_t capacity;
+    uint32_t count;
+};
+
+static int request_add(struct request* req, const char* token, size_t len) {
+    if ((len > UINT32_MAX) || (req->count == UINT32_MAX)) {
+        fprintf(stderr, "[Error] Request too large\n");
+        return FAILURE;
+    }
+
+    if (req->capacity - req->size < len + 4) {
+        size_t capacity = (req->capacity > 0) ? req->capacity : 4096;
+
+        while (capacity - req->size < len + 4) {
+            capacity *= 2;
+        }
+
+        unsigned char* buffer = realloc(req->buffer, capacity);
+
+        if (buffer == NULL) {
+            fprintf(stderr, "[Error] Failed to allocate %zu bytes for the request\n", capacity);
+            return FAILURE;
+        }
+
+        req->buffer = buffer;
+        req->capacity = capacity;
+    }
+
+    store_le(req->buffer + req->size, (uint32_t) len, 4);
+    memcpy(req->buffer + req->size + 4, token, len);
+
+    req->size += len + 4;
+    ++req->count;
+
+    return SUCCESS;
+}
+
+// Gather every whitespace-separated number in standard input, which is read
+// in full first.
+static int request_add_stdin(struct request* req) {
+    char* text = NULL;
+    size_t size = 0;
+    size_t capacity = 0;
+
+    for (;;) {
+        if (capacity - size < 4096) {
+            capacity = (capacity > 0) ? capacity * 2 : 65536;
+
+            char* grown = realloc(text, capacity);
+
+            if (grown == NULL) {
+                fprintf(stderr, "[Error] Failed to allocate %zu bytes for standard input\n", capacity);
+                free(text);
+                return FAILURE;
+            }
+
+            text = grown;
+        }
+
+        ssize_t bytes = read(STDIN_FILENO, text + size, capacity - size);
+
+        if (bytes == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            fprintf(stderr, "[Error] Failed to read from <stdin> (%s)\n", strerror(errno));
+            free(text);
+            return FAILURE;
+        }
+
+        if (bytes == 0) {
+            break;
+        }
+
+        size += (size_t) bytes;
+    }
+
+    int result = SUCCESS;
+
+    for (size_t i = 0; (i < size) && (result == SUCCESS); ) {
+        if (isspace((unsigned char) text[i])) {
+            ++i;
+            continue;
+        }
+
+        size_t start = i;
+
+        while ((i < size) && !isspace((unsigned char) text[i])) {
+            ++i;
+        }
+
+        result = request_add(req, text + start, i - start);
+    }
+
+    free(text);
+
+    return result;
+}
+
+static void print_usage(void) {
+    printf("Usage: hex2dec-client [OPTIONS] [NUMBERS...]\n\n");
+    printf("Send the numbers, or the numbers in standard input if there are none, to a\n");
+    printf("hex2dec server, and print the results.\n\n");
+    printf("    -h, --help        Print this help menu and exit\n");
+    printf("    -p, --pretty-print\n");
+    printf("                      Ask the coprocess to group the digits\n");
+    printf("        --socket=PATH Connect to the server listening on PATH\n");
+    printf("        --server=PROGRAM\n");
+    printf("                      Start PROGRAM as the coprocess (default: %s)\n\n", DEFAULT_SERVER);
+}
+
+int main(int argc, char* argv[]) {
+    const char* socket_path = NULL;
+    const char* program = DEFAULT_SERVER;
+    int pretty_print = FALSE;
+
+    struct request req = { NULL, 0, 0, 0 };
+
+    // Reserve room for the number of inputs, which is only known at the end.
+    if (request_add(&req, "", 0) == FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    req.count = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if ((strcmp(argv[i], "-h") == 0) || (strcmp(argv[i], "--help") == 0)) {
+            print_usage();
+            return EXIT_SUCCESS;
+        } else if ((strcmp(argv[i], "-p") == 0) || (strcmp(argv[i], "--pretty-print") == 0)) {
+            pretty_print = TRUE;
+        } else if (strncmp(argv[i], "--socket=", 9) == 0) {
+            socket_path = argv[i] + 9;
+        } else if (strncmp(argv[i], "--server=", 9) == 0) {
+            program = argv[i] + 9;
+        } else if ((argv[i][0] == '-') && (argv[i][1] == '-')) {
+            fprintf(stderr, "[Error] Invalid option: %s\n", argv[i]);
+            return EXIT_FAILURE;
+        } else if (request_add(&req, argv[i], strlen(argv[i])) == FAILURE) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    if ((req.count == 0) && (request_add_stdin(&req) == FAILURE)) {
+        return EXIT_FAILURE;
+    }
+
+    store_le(req.buffer, req.count, 4);
+
+    int in_fd;
+    int out_fd;
+    pid_t pid = -1;
+
+    if (socket_path) {
+        if (connect_socket(socket_path, &in_fd, &out_fd) == FAILURE) {
+            return EXIT_FAILURE;
+        }
+    } else if (start_server(program, pretty_print, &in_fd, &out_fd, &pid) == FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    // The server holds the whole response until it has read the request, so
+    // it is safe to send all of it before reading anything.
+    int status = (write_exact(out_fd, req.buffer, req.size) == FAILURE) ? EXIT_FAILURE : EXIT_SUCCESS;
+
+    unsigned char header[5];
+    char* value = NULL;
+    size_t capacity = 0;
+
+    if ((status == EXIT_SUCCESS) && (read_exact(in_fd, header, 4) == SUCCESS) && ((uint32_t) load_le(header, 4) == req.count)) {
+        for (uint32_t i = 0; i < req.count; ++i) {
+            if (read_exact(in_fd, header, 5) == FAILURE) {
+                status = EXIT_FAILURE;
+                break;
+            }
+
+            size_t len = (uint32_t) load_le(header + 1, 4);
+
+            if (len > capacity) {
+                char* grown = realloc(value, len);
+
+                if (grown == NULL) {
+                    fprintf(stderr, "[Error] Failed to allocate %zu bytes for the response\n", len);
+                    status = EXIT_FAILURE;
+                    break;
+                }
+
+                value = grown;
+                capacity = len;
+            }
+
+            if ((len > 0) && (read_exact(in_fd, value, len) == FAILURE)) {
+                status = EXIT_FAILURE;
+                break;
+            }
+
+            if (header[0] != 0) {
+                fprintf(stderr, "[Error] Invalid value in number.\n");
+                status = EXIT_FAILURE;
+                continue;
+            }
+
+            // The value may be longer than 'printf' can take a precision.
+            fwrite(value, 1, len, stdout);
+            putchar('\n');
+        }
+    } else {
+        status = EXIT_FAILURE;
+    }
+
+    free(value);
+    free(req.buffer);
+
+    close(out_fd);
+
+    if (in_fd != out_fd) {
+        close(in_fd);
+    }
+
+    if (pid > 0) {
+        waitpid(pid, NULL, 0);
+    }
+
+    return status;
+}
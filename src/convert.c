@@ -0,0 +1,400 @@
+
+#include "hex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                CONVERT.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This file contains the conversion of a single input token, from
+ *          parsing the hexadecimal string to printing the decimal result,
+ *          optionally pretty-printed using the locale-specific formatting,
+ *          or from and to any other base the user asks for.
+ *          The same converter is used for every input, regardless of where
+ *          the inputs come from.
+ *
+ *          Rather than text, the results may also be written as binary
+ *          records, or as JSON objects, one per line.
+ *
+ *  **************************************************************************/
+
+void converter_init(struct converter* conv) {
+    // Allocate and initialize arbitrary-precision integer to hold decimal
+    // value for conversion of any size hexadecimal number.
+    mpz_init(conv->n);
+
+    conv->from = base_info(16);
+    conv->to = base_info(10);
+    conv->out = NULL;
+    conv->grouping = NULL;
+    conv->pretty_print = FALSE;
+    conv->invalid = FALSE;
+    conv->threads = 1;
+    conv->format = FORMAT_TEXT;
+
+    // Unless the user asks otherwise, the first invalid input stops the
+    // conversion.
+    conv->on_error = ON_ERROR_ABORT;
+    conv->tokens = 0;
+    conv->rejected = 0;
+    conv->rejected_range = 0;
+    conv->invalid_index = 0;
+    conv->invalid_offset = 0;
+
+    // The scratch buffer for the digits and the cache of powers of the base
+    // used to split giant numbers are only allocated once they are first
+    // needed.
+    conv->digits = NULL;
+    conv->digits_capacity = 0;
+    conv->powers = NULL;
+    conv->quotients = NULL;
+    conv->remainders = NULL;
+    conv->levels = 0;
+}
+
+void converter_clear(struct converter* conv) {
+    emit_clear(conv);
+    mpz_clear(conv->n);
+}
+
+void report_invalid_token(int reason, uint64_t index, uint64_t offset) {
+    // Every digit of a value too large for u64 is valid, so there is no
+    // character to point at.
+    if (reason == INVALID_RANGE) {
+        fprintf(stderr, "[Error] Value does not fit in u64 (token %" PRIu64 ").\n", index);
+        return;
+    }
+
+    // The inputs are numbered from one, like lines, while the offset is the
+    // number of bytes before the first invalid character.
+    fprintf(stderr, "[Error] Invalid value in number (token %" PRIu64 ", byte %" PRIu64 ").\n", index, offset);
+}
+
+// Reinitialize every number still holding memory from the arena, which is
+// about to be reset. Numbers that grew out of the arena keep their memory
+// from the system allocator for the next input.
+static void forget_arena(struct converter* conv) {
+    if (arena_owns(mpz_limbs_read(conv->n))) {
+        mpz_init(conv->n);
+    }
+
+    if (conv->levels == 0) {
+        return;
+    }
+
+    if (arena_owns(mpz_limbs_read(conv->scratch))) {
+        mpz_init(conv->scratch);
+    }
+
+    for (size_t i = 0; i < conv->levels; ++i) {
+        if (arena_owns(mpz_limbs_read(conv->quotients[i]))) {
+            mpz_init(conv->quotients[i]);
+        }
+
+        if (arena_owns(mpz_limbs_read(conv->remainders[i]))) {
+            mpz_init(conv->remainders[i]);
+        }
+    }
+}
+
+// Write 'str' as a JSON string, escaping the quotes, the backslashes, the
+// control characters, and every byte outside of ASCII. Valid inputs never
+// need escaping, but rejected inputs are written out as well, and they may
+// hold any bytes at all, which would not always be valid UTF-8. Every such
+// byte is written as the code point of the same value, so the string is
+// always valid JSON, and the original bytes can still be told apart.
+static int write_json_string(struct output* out, const char* str, size_t len) {
+    static const char hex_digits[] = "0123456789abcdef";
+
+    // Every character takes up at most six bytes once escaped.
+    char* dst = output_reserve(out, len * 6 + 2);
+
+    if (dst == NULL) {
+        return FAILURE;
+    }
+
+    char* p = dst;
+
+    *p++ = '"';
+
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char c = (unsigned char) str[i];
+
+        if ((c == '"') || (c == '\\')) {
+            *p++ = '\\';
+            *p++ = (char) c;
+        } else if ((c < 0x20) || (c >= 0x7F)) {
+            memcpy(p, "\\u00", 4);
+            p[4] = hex_digits[c >> 4];
+            p[5] = hex_digits[c & 0xF];
+            p += 6;
+        } else {
+            *p++ = (char) c;
+        }
+    }
+
+    *p++ = '"';
+
+    output_commit(out, (size_t) (p - dst));
+
+    return SUCCESS;
+}
+
+int convert_value(struct converter* conv, const char* digits, size_t count) {
+    int previous = stats_stage(STAGE_DECODE);
+
+    // Leading zeros do not count toward the size of the number.
+    while ((count > 0) && (*digits == '0')) {
+        ++digits;
+        --count;
+    }
+
+    // Most inputs fit in a native integer, in which case GMP is bypassed
+    // entirely. Otherwise, convert the input in a single pass over its
+    // digits, which is split between threads for giant hexadecimal numbers.
+    // The conversion overwrites the previous value of the number, so there
+    // is no need to reset it at the start of each input-processing step.
+    //
+    // The emitter takes care of inserting the separators between the digit
+    // groups when pretty-printing.
+    const struct base* from = conv->from;
+    const int hexadecimal = (from->radix == 16);
+    const int binary = (conv->format == FORMAT_BINARY) || (conv->format == FORMAT_U64);
+
+    int result = SUCCESS;
+
+    if (count <= (size_t) from->chunk_digits * FAST_PATH_CHUNKS) {
+        fast_uint value = hexadecimal ? hex_to_uint(digits, count) : digits_to_uint(from, digits, count);
+
+        if (thread_stats) {
+            ++thread_stats->fast_path;
+        }
+
+        stats_stage(STAGE_CONVERT);
+
+        if (binary) {
+            result = emit_binary_uint(conv, value);
+        } else {
+            emit_uint(conv, value);
+        }
+    } else {
+        // Every temporary GMP needs while converting the number comes from
+        // the arena, which is reset all at once afterwards.
+        arena_enter();
+
+        if (hexadecimal) {
+            hex_to_mpz_parallel(conv->n, digits, count, conv->threads);
+        } else {
+            digits_to_mpz(conv->n, from, digits, count);
+        }
+
+        stats_stage(STAGE_CONVERT);
+        result = binary ? emit_binary_mpz(conv, conv->n) : emit_mpz(conv, conv->n);
+
+        forget_arena(conv);
+        arena_leave();
+    }
+
+    stats_stage(previous);
+
+    return result;
+}
+
+int convert_token(struct converter* conv, const char* token, size_t len) {
+    size_t start;
+    size_t end;
+
+    // Validate the input and find its digits. Every input is read in the
+    // input base, so a number entered in octal notation, say, is interpreted
+    // as hex unless the user asks for base 8.
+    //
+    // The error is not reported here, but rather by the caller, so that
+    // when converting in parallel, it is only reported once every input
+    // before it has been written out.
+    int previous = stats_stage(STAGE_DECODE);
+
+    if (thread_stats) {
+        stats_input(thread_stats, len);
+    }
+
+    size_t invalid_offset;
+
+    if (digit_span(conv->from, token, len, &start, &end, &invalid_offset) == FAILURE) {
+        if (thread_stats) {
+            ++thread_stats->invalid;
+        }
+
+        conv->invalid = INVALID_DIGIT;
+        conv->invalid_offset = invalid_offset;
+        stats_stage(previous);
+        return FAILURE;
+    }
+
+    stats_stage(STAGE_FORMAT);
+
+    // In the NDJSON format, the value is a string following the input.
+    if (conv->format == FORMAT_NDJSON) {
+        if ((output_write(conv->out, "{\"input\":", 9) == FAILURE)
+            || (write_json_string(conv->out, token, len) == FAILURE)
+            || (output_write(conv->out, ",\"value\":\"", 10) == FAILURE)) {
+            stats_stage(previous);
+            return FAILURE;
+        }
+    } else if (conv->pretty_print == TRUE) {
+        // Pretty print if specified via command-line option
+        // Print the original input string first
+        char* echo = output_reserve(conv->out, len + 3);
+
+        if (echo == NULL) {
+            stats_stage(previous);
+            return FAILURE;
+        }
+
+        for (size_t i = 0; i < len; ++i) {
+            // Always print a lowercase letter for the prefix, be it the
+            // hexadecimal 'x' or the binary 'b' or octal 'o'. An 'x' is only
+            // ever part of the prefix in hexadecimal, since it is a digit in
+            // the bases from 34 up.
+            if (((conv->from->radix == 16) && ((token[i] == 'x') || (token[i] == 'X'))) || ((i == 1) && (start == 2))) {
+                echo[i] = (char) tolower((unsigned char) token[i]);
+                continue;
+            }
+
+            // For every other character in the hexadecimal input string,
+            // make sure the alphanumeric characters are printed as upper-
+            // case, even if that is not how they were originally specified.
+            echo[i] = (char) toupper((unsigned char) token[i]);
+        }
+
+        // Print division ' = '
+        memcpy(echo + len, " = ", 3);
+
+        output_commit(conv->out, len + 3);
+    }
+
+    // Then print the converted number, followed by a newline character,
+    // except for binary records, which are written out as soon as they are
+    // ready if the output is line-buffered.
+    int result = convert_value(conv, token + start, end - start);
+
+    if (conv->invalid) {
+        // The value does not fit in a u64 record, which nothing has been
+        // written for yet. No single character is at fault, so there is no
+        // offset to report.
+        if (thread_stats) {
+            ++thread_stats->invalid;
+        }
+
+        conv->invalid_offset = 0;
+    } else if (result == SUCCESS) {
+        if (conv->format == FORMAT_NDJSON) {
+            result = output_write(conv->out, "\"}", 2);
+        }
+
+        if ((conv->format == FORMAT_BINARY) || (conv->format == FORMAT_U64)) {
+            result = conv->out->line_buffered ? output_flush(conv->out) : SUCCESS;
+        } else if (result == SUCCESS) {
+            result = output_end_line(conv->out);
+        }
+    }
+
+    stats_stage(previous);
+
+    return result;
+}
+
+int convert_input(struct converter* conv, const char* token, size_t len, uint64_t index, uint64_t offset) {
+    int result = convert_token(conv, token, len);
+
+    if ((result == SUCCESS) || !conv->invalid) {
+        return result;
+    }
+
+    conv->invalid_index = index;
+    conv->invalid_offset += offset;
+
+    if (conv->on_error == ON_ERROR_ABORT) {
+        return FAILURE;
+    }
+
+    // Otherwise, the input is rejected, and nothing was written for it, so
+    // the conversion simply carries on with the next one. The placeholder
+    // and the record take the place of the result, so that the results
+    // still line up with the inputs.
+    if (conv->invalid == INVALID_RANGE) {
+        ++conv->rejected_range;
+    }
+
+    conv->invalid = FALSE;
+    ++conv->rejected;
+
+    // A u64 record has no room to mark an invalid input, so it is skipped.
+    if ((conv->on_error == ON_ERROR_SKIP) || (conv->format == FORMAT_U64)) {
+        return SUCCESS;
+    }
+
+    const int record = (conv->on_error == ON_ERROR_RECORD);
+
+    // In the binary format, the invalid length is followed by the position
+    // of the input, as two more 64-bit integers, in a record.
+    if (conv->format == FORMAT_BINARY) {
+        size_t size = record ? 20 : 4;
+        unsigned char* bytes = (unsigned char*) output_reserve(conv->out, size);
+
+        if (bytes == NULL) {
+            return FAILURE;
+        }
+
+        store_le(bytes, BINARY_INVALID, 4);
+
+        if (record) {
+            store_le(bytes + 4, index, 8);
+            store_le(bytes + 12, conv->invalid_offset, 8);
+        }
+
+        output_commit(conv->out, size);
+
+        return conv->out->line_buffered ? output_flush(conv->out) : SUCCESS;
+    }
+
+    if (conv->format == FORMAT_NDJSON) {
+        if ((output_write(conv->out, "{\"input\":", 9) == FAILURE) || (write_json_string(conv->out, token, len) == FAILURE)) {
+            return FAILURE;
+        }
+    }
+
+    if (!record) {
+        const char* placeholder = (conv->format == FORMAT_NDJSON) ? ",\"value\":null}" : INVALID_PLACEHOLDER;
+
+        if (output_write(conv->out, placeholder, strlen(placeholder)) == FAILURE) {
+            return FAILURE;
+        }
+
+        return output_end_line(conv->out);
+    }
+
+    // Long enough for the record with the largest possible numbers, along
+    // with the terminating null character written by 'snprintf'.
+    const size_t size = 96;
+
+    char* text = output_reserve(conv->out, size);
+
+    if (text == NULL) {
+        return FAILURE;
+    }
+
+    int length = (conv->format == FORMAT_NDJSON)
+        ? snprintf(text, size, ",\"error\":\"invalid\",\"token\":%" PRIu64 ",\"offset\":%" PRIu64 "}", index, conv->invalid_offset)
+        : snprintf(text, size, "invalid token=%" PRIu64 " offset=%" PRIu64, index, conv->invalid_offset);
+
+    output_commit(conv->out, (size_t) length);
+
+    return output_end_line(conv->out);
+}
@@ -0,0 +1,245 @@
+
+#include "hex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                DECODE.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This file contains the hexadecimal validation and decoding
+ *          kernels used by the parser. Each kernel classifies a block of
+ *          characters at a time and either reports the offset of the first
+ *          character that is not a hex digit, or decodes pairs of digits
+ *          into packed bytes, most significant digit first.
+ *
+ *          There is a portable table-driven kernel, as well as SSE2 and
+ *          AVX2 kernels on x86 processors. The best kernel supported by the
+ *          processor is selected at runtime the first time it is requested.
+ *
+ *  **************************************************************************/
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEX_KERNEL_X86 1
+#include <immintrin.h>
+#endif // __GNUC__ && (__x86_64__ || __i386__)
+
+// Value of every possible character as a hexadecimal digit plus one, so that
+// the zero-initialized entries mark the characters that are not hex digits.
+static const unsigned char hex_value_table[UCHAR_MAX + 1] = {
+    ['0'] =  1, ['1'] =  2, ['2'] =  3, ['3'] =  4, ['4'] =  5,
+    ['5'] =  6, ['6'] =  7, ['7'] =  8, ['8'] =  9, ['9'] = 10,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+};
+
+int hex_value(char c) {
+    return hex_value_table[(unsigned char) c] - 1;
+}
+
+static size_t scan_scalar(const char* str, size_t len) {
+    size_t i = 0;
+
+    while ((i < len) && hex_value_table[(unsigned char) str[i]]) {
+        ++i;
+    }
+
+    return i;
+}
+
+static size_t decode_scalar(const char* str, size_t len, unsigned char* out) {
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        int high = hex_value(str[i]);
+        int low = hex_value(str[i + 1]);
+
+        if (high < 0) {
+            return i;
+        }
+
+        if (low < 0) {
+            return i + 1;
+        }
+
+        out[i / 2] = (unsigned char) ((high << 4) | low);
+    }
+
+    return len;
+}
+
+#if defined(HEX_KERNEL_X86) && defined(__SSE2__)
+
+// Classify sixteen characters at once. The comparisons are signed, so any
+// byte with the high bit set is negative and fails both range checks. Each
+// byte of the result is set to 0xFF if the corresponding character is a hex
+// digit, and the decoded value of every valid digit is stored in 'value'.
+static inline __m128i classify_sse2(__m128i chars, __m128i* value) {
+    const __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+
+    const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                                        _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+    const __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                        _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+
+    if (value) {
+        *value = _mm_or_si128(_mm_and_si128(digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+                              _mm_and_si128(alpha, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+    }
+
+    return _mm_or_si128(digit, alpha);
+}
+
+static size_t scan_sse2(const char* str, size_t len) {
+    size_t i = 0;
+
+    for ( ; i + 16 <= len; i += 16) {
+        const __m128i chars = _mm_loadu_si128((const __m128i*) (str + i));
+        const unsigned mask = (unsigned) _mm_movemask_epi8(classify_sse2(chars, NULL));
+
+        if (mask != 0xFFFF) {
+            return i + (size_t) __builtin_ctz(~mask);
+        }
+    }
+
+    return i + scan_scalar(str + i, len - i);
+}
+
+static size_t decode_sse2(const char* str, size_t len, unsigned char* out) {
+    size_t i = 0;
+
+    for ( ; i + 16 <= len; i += 16) {
+        __m128i value;
+
+        const __m128i chars = _mm_loadu_si128((const __m128i*) (str + i));
+        const unsigned mask = (unsigned) _mm_movemask_epi8(classify_sse2(chars, &value));
+
+        if (mask != 0xFFFF) {
+            return i + (size_t) __builtin_ctz(~mask);
+        }
+
+        // Merge each pair of nibbles into a byte. Viewed as 16-bit lanes, the
+        // more significant digit is in the low byte and the less significant
+        // one in the high byte, so the packed byte is (low << 4) | (high >> 8),
+        // which always fits in the low byte of the lane.
+        const __m128i high = _mm_slli_epi16(_mm_and_si128(value, _mm_set1_epi16(0x00FF)), 4);
+        const __m128i low = _mm_srli_epi16(value, 8);
+        const __m128i packed = _mm_packus_epi16(_mm_or_si128(high, low), _mm_setzero_si128());
+
+        _mm_storel_epi64((__m128i*) (out + i / 2), packed);
+    }
+
+    size_t tail = decode_scalar(str + i, len - i, out + i / 2);
+
+    return i + tail;
+}
+
+#endif // HEX_KERNEL_X86 && __SSE2__
+
+#if defined(HEX_KERNEL_X86)
+
+__attribute__((target("avx2")))
+static inline __m256i classify_avx2(__m256i chars, __m256i* value) {
+    const __m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+
+    const __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)),
+                                           _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars));
+    const __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                           _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+
+    if (value) {
+        *value = _mm256_or_si256(_mm256_and_si256(digit, _mm256_sub_epi8(chars, _mm256_set1_epi8('0'))),
+                                 _mm256_and_si256(alpha, _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10))));
+    }
+
+    return _mm256_or_si256(digit, alpha);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_avx2(const char* str, size_t len) {
+    size_t i = 0;
+
+    for ( ; i + 32 <= len; i += 32) {
+        const __m256i chars = _mm256_loadu_si256((const __m256i*) (str + i));
+        const unsigned mask = (unsigned) _mm256_movemask_epi8(classify_avx2(chars, NULL));
+
+        if (mask != 0xFFFFFFFF) {
+            return i + (size_t) __builtin_ctz(~mask);
+        }
+    }
+
+    return i + scan_scalar(str + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t decode_avx2(const char* str, size_t len, unsigned char* out) {
+    size_t i = 0;
+
+    for ( ; i + 32 <= len; i += 32) {
+        __m256i value;
+
+        const __m256i chars = _mm256_loadu_si256((const __m256i*) (str + i));
+        const unsigned mask = (unsigned) _mm256_movemask_epi8(classify_avx2(chars, &value));
+
+        if (mask != 0xFFFFFFFF) {
+            return i + (size_t) __builtin_ctz(~mask);
+        }
+
+        const __m256i high = _mm256_slli_epi16(_mm256_and_si256(value, _mm256_set1_epi16(0x00FF)), 4);
+        const __m256i low = _mm256_srli_epi16(value, 8);
+
+        // The AVX2 pack instruction operates on each 128-bit half separately,
+        // so the two packed quadwords end up in elements 0 and 2.
+        __m256i packed = _mm256_packus_epi16(_mm256_or_si256(high, low), _mm256_setzero_si256());
+        packed = _mm256_permute4x64_epi64(packed, 0x08);
+
+        _mm_storeu_si128((__m128i*) (out + i / 2), _mm256_castsi256_si128(packed));
+    }
+
+    size_t tail = decode_scalar(str + i, len - i, out + i / 2);
+
+    return i + tail;
+}
+
+#endif // HEX_KERNEL_X86
+
+static const struct hex_kernel kernel_scalar = { "scalar", scan_scalar, decode_scalar };
+
+#if defined(HEX_KERNEL_X86) && defined(__SSE2__)
+static const struct hex_kernel kernel_sse2 = { "sse2", scan_sse2, decode_sse2 };
+#endif // HEX_KERNEL_X86 && __SSE2__
+
+#if defined(HEX_KERNEL_X86)
+static const struct hex_kernel kernel_avx2 = { "avx2", scan_avx2, decode_avx2 };
+#endif // HEX_KERNEL_X86
+
+// The kernel is selected once, by whichever thread asks for it first, and
+// every other thread waits for that selection to finish.
+static const struct hex_kernel* selected = &kernel_scalar;
+static pthread_once_t selected_once = PTHREAD_ONCE_INIT;
+
+static void select_kernel(void) {
+    #if defined(HEX_KERNEL_X86)
+    __builtin_cpu_init();
+
+    #if defined(__SSE2__)
+    if (__builtin_cpu_supports("sse2")) {
+        selected = &kernel_sse2;
+    }
+    #endif // __SSE2__
+
+    if (__builtin_cpu_supports("avx2")) {
+        selected = &kernel_avx2;
+    }
+    #endif // HEX_KERNEL_X86
+}
+
+const struct hex_kernel* hex_kernel(void) {
+    pthread_once(&selected_once, select_kernel);
+
+    return selected;
+}
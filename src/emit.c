@@ -0,0 +1,707 @@
+
+#include "hex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                EMIT.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This file contains the emitter, which prints the value of the
+ *          converted number in the output base, base 10 by default. Numbers
+ *          of moderate size are converted in one go into a reusable buffer,
+ *          but giant numbers are recursively split in half by powers of the
+ *          base, so that the digits can be written out in chunks, from the
+ *          most significant to the least significant, as soon as each chunk
+ *          is ready.
+ *
+ *          Because every chunk other than the first has a fixed width, the
+ *          number of digits to the right of each chunk is always known, and
+ *          the digit grouping can be applied to each chunk independently.
+ *
+ *          In bases that are powers of two, every digit is a fixed group of
+ *          bits, so the digits are read directly off the limbs instead.
+ *
+ *          The binary formats skip the digits altogether, and write out the
+ *          bytes of the number itself.
+ *
+ *  **************************************************************************/
+
+// Numbers with at most this many digits are converted directly by GMP,
+// without splitting them first.
+
+#ifndef EMIT_DIRECT_DIGITS
+#define EMIT_DIRECT_DIGITS (1 << 16)
+#endif // EMIT_DIRECT_DIGITS
+
+// Number of digits in each chunk of a split number. The powers of the base
+// used for splitting are b^(EMIT_CHUNK_DIGITS * 2^i), but only their odd
+// factor is kept in the cache, as 5^(EMIT_CHUNK_DIGITS * 2^i) for base 10.
+
+#ifndef EMIT_CHUNK_DIGITS
+#define EMIT_CHUNK_DIGITS (1 << 12)
+#endif // EMIT_CHUNK_DIGITS
+
+// Every pair of decimal digits from 00 to 99, so that native integers can be
+// converted two digits per division.
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Splits with at least this many digits in their low half are printed on two
+// threads, if the converter may use more than one.
+
+#ifndef PARALLEL_EMIT_DIGITS
+#define PARALLEL_EMIT_DIGITS (1 << 18)
+#endif // PARALLEL_EMIT_DIGITS
+
+// Digits of every base, which are printed in uppercase, just like the
+// hexadecimal inputs are echoed when pretty-printing.
+static const char digit_chars[MAX_BASE + 1] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+static const char zeros[64] = "0000000000000000000000000000000000000000000000000000000000000000";
+
+// Make sure the reusable digit buffer can hold 'count' digits, along with
+// the sign and null terminator 'mpz_get_str' may write.
+static int reserve_digits(struct converter* conv, size_t count) {
+    if (conv->digits_capacity >= count + 2) {
+        return SUCCESS;
+    }
+
+    char* digits = realloc(conv->digits, count + 2);
+
+    if (digits == NULL) {
+        fprintf(stderr, "[Error] Failed to allocate %zu bytes for the decimal digits\n", count + 2);
+        return FAILURE;
+    }
+
+    conv->digits = digits;
+    conv->digits_capacity = count + 2;
+
+    return SUCCESS;
+}
+
+// Make sure the power cache holds every power up to 'level', along with the
+// quotient and remainder used at each level of the recursion.
+static int reserve_powers(struct converter* conv, size_t level) {
+    if (level < conv->levels) {
+        return SUCCESS;
+    }
+
+    if (conv->levels == 0) {
+        mpz_init(conv->scratch);
+    }
+
+    // The powers are kept from one number to the next, so they must not be
+    // allocated from the arena, even while converting a number.
+    int arena_active = arena_suspend();
+
+    mpz_t* powers = realloc(conv->powers, (level + 1) * sizeof (mpz_t));
+
+    if (powers != NULL) {
+        conv->powers = powers;
+    }
+
+    mpz_t* quotients = realloc(conv->quotients, (level + 1) * sizeof (mpz_t));
+
+    if (quotients != NULL) {
+        conv->quotients = quotients;
+    }
+
+    mpz_t* remainders = realloc(conv->remainders, (level + 1) * sizeof (mpz_t));
+
+    if (remainders != NULL) {
+        conv->remainders = remainders;
+    }
+
+    if ((powers == NULL) || (quotients == NULL) || (remainders == NULL)) {
+        fprintf(stderr, "[Error] Failed to allocate the power cache\n");
+        arena_resume(arena_active);
+        return FAILURE;
+    }
+
+    for (size_t i = conv->levels; i <= level; ++i) {
+        mpz_init(conv->powers[i]);
+        mpz_init(conv->quotients[i]);
+        mpz_init(conv->remainders[i]);
+
+        if (i == 0) {
+            mpz_ui_pow_ui(conv->powers[i], (unsigned long) (conv->to->radix >> conv->to->shift), EMIT_CHUNK_DIGITS);
+        } else {
+            mpz_mul(conv->powers[i], conv->powers[i - 1], conv->powers[i - 1]);
+        }
+    }
+
+    conv->levels = level + 1;
+
+    arena_resume(arena_active);
+
+    return SUCCESS;
+}
+
+void emit_clear(struct converter* conv) {
+    for (size_t i = 0; i < conv->levels; ++i) {
+        mpz_clear(conv->powers[i]);
+        mpz_clear(conv->quotients[i]);
+        mpz_clear(conv->remainders[i]);
+    }
+
+    if (conv->levels > 0) {
+        mpz_clear(conv->scratch);
+    }
+
+    free(conv->powers);
+    free(conv->quotients);
+    free(conv->remainders);
+    free(conv->digits);
+
+    conv->powers = NULL;
+    conv->quotients = NULL;
+    conv->remainders = NULL;
+    conv->levels = 0;
+    conv->digits = NULL;
+    conv->digits_capacity = 0;
+}
+
+// Write a run of digits, where 'after' is the number of digits that will
+// follow the run. When pretty-printing, the formatted length of the run is
+// computed up front, and the digits and separators are then written into
+// the output buffer in a single pass. The locale's grouping is only meant
+// for decimal numbers, so it never applies to any other base.
+static void emit_digits(struct converter* conv, const char* digits, size_t count, size_t after) {
+    int previous = stats_stage(STAGE_FORMAT);
+
+    if ((conv->grouping == NULL) || (conv->grouping->count == 0) || (conv->to->radix != 10)) {
+        output_write(conv->out, digits, count);
+    } else {
+        size_t len = grouping_length(conv->grouping, count, after);
+        char* dst = output_reserve(conv->out, len);
+
+        if (dst != NULL) {
+            grouping_format(conv->grouping, digits, count, after, dst);
+            output_commit(conv->out, len);
+        }
+    }
+
+    stats_stage(previous);
+}
+
+static void emit_zeros(struct converter* conv, size_t count, size_t after) {
+    while (count > 0) {
+        size_t run = (count < sizeof zeros) ? count : sizeof zeros;
+
+        emit_digits(conv, zeros, run, after + count - run);
+        count -= run;
+    }
+}
+
+// Convert a chunk of the number with GMP. If 'width' is not zero, the chunk
+// is padded with leading zeros up to that width.
+static void emit_chunk(struct converter* conv, const mpz_t x, size_t width, size_t after) {
+    // A negative base asks GMP for uppercase digits.
+    mpz_get_str(conv->digits, -conv->to->radix, x);
+
+    size_t len = strlen(conv->digits);
+
+    if (width > len) {
+        emit_zeros(conv, width - len, after + len);
+    }
+
+    emit_digits(conv, conv->digits, len, after);
+}
+
+// Divide 'x', which is less than the power of the base at 'level + 1', by the
+// power at 'level', into the quotient and remainder at that level. If 'x' is
+// not padded and is less than the power itself, there is nothing to split,
+// and FALSE is returned instead.
+static int emit_divide(struct converter* conv, const mpz_t x, size_t level, int padded) {
+    size_t low_digits = (size_t) EMIT_CHUNK_DIGITS << level;
+    size_t low_bits = low_digits * (size_t) conv->to->shift;
+
+    mpz_ptr quotient = conv->quotients[level];
+    mpz_ptr remainder = conv->remainders[level];
+
+    // Dividing by 10^k is the same as shifting right by k bits and dividing
+    // the result by 5^k, which is a much smaller divisor. The remainder is
+    // then put back together from the remainder of that division and the k
+    // bits that were shifted out. Every other even base is split the same
+    // way, by its own power of two and odd factor.
+    mpz_tdiv_q_2exp(quotient, x, low_bits);
+
+    if (!padded && (mpz_cmp(quotient, conv->powers[level]) < 0)) {
+        return FALSE;
+    }
+
+    mpz_tdiv_r_2exp(remainder, x, low_bits);
+    mpz_tdiv_qr(quotient, conv->scratch, quotient, conv->powers[level]);
+    mpz_mul_2exp(conv->scratch, conv->scratch, low_bits);
+    mpz_add(remainder, remainder, conv->scratch);
+
+    return TRUE;
+}
+
+// Emit 'x', which is less than the power of the base at 'level + 1', by
+// dividing it by the power at 'level'. The remainder is the low half of the
+// digits, which is always padded to its full width, while the quotient is the
+// high half, which is only padded if 'x' itself is.
+static void emit_split(struct converter* conv, const mpz_t x, ssize_t level, int padded, size_t after) {
+    if (level < 0) {
+        emit_chunk(conv, x, padded ? EMIT_CHUNK_DIGITS : 0, after);
+        return;
+    }
+
+    if (!emit_divide(conv, x, (size_t) level, padded)) {
+        emit_split(conv, x, level - 1, FALSE, after);
+        return;
+    }
+
+    size_t low_digits = (size_t) EMIT_CHUNK_DIGITS << level;
+
+    emit_split(conv, conv->quotients[level], level - 1, padded, after + low_digits);
+    emit_split(conv, conv->remainders[level], level - 1, TRUE, after);
+}
+
+// The low half of a split printed into memory by another thread.
+struct emit_task {
+    struct converter conv;
+    struct output out;
+    mpz_srcptr x;
+    ssize_t level;
+    size_t after;
+    pthread_t thread;
+
+    // The statistics of the thread, which are merged into those of the
+    // thread that started it, if it collects any.
+    struct stats stats;
+    int collect_stats;
+};
+
+static void emit_split_parallel(struct converter* conv, const mpz_t x, ssize_t level, int padded, size_t after);
+
+static void* emit_task_main(void* arg) {
+    struct emit_task* task = arg;
+
+    if (task->collect_stats) {
+        stats_init(&task->stats);
+        thread_stats = &task->stats;
+        stats_stage(STAGE_CONVERT);
+    }
+
+    // The temporaries of the thread come from an arena of its own, just
+    // like those of the thread that started it. The quotients, remainders,
+    // and scratch number outlive the thread, since they are cleared by the
+    // thread that started it, so any of them holding memory from the arena
+    // are reinitialized before the arena goes away with the thread.
+    struct converter* conv = &task->conv;
+
+    arena_enter();
+
+    emit_split_parallel(conv, task->x, task->level, TRUE, task->after);
+
+    for (size_t i = 0; i < conv->levels; ++i) {
+        if (arena_owns(mpz_limbs_read(conv->quotients[i]))) {
+            mpz_init(conv->quotients[i]);
+        }
+
+        if (arena_owns(mpz_limbs_read(conv->remainders[i]))) {
+            mpz_init(conv->remainders[i]);
+        }
+    }
+
+    if (arena_owns(mpz_limbs_read(conv->scratch))) {
+        mpz_init(conv->scratch);
+    }
+
+    arena_free();
+
+    stats_stage(STAGE_OTHER);
+
+    return NULL;
+}
+
+static void emit_task_clear(struct emit_task* task) {
+    for (size_t i = 0; i < task->conv.levels; ++i) {
+        mpz_clear(task->conv.quotients[i]);
+        mpz_clear(task->conv.remainders[i]);
+    }
+
+    mpz_clear(task->conv.scratch);
+
+    free(task->conv.quotients);
+    free(task->conv.remainders);
+    free(task->conv.digits);
+
+    output_free(&task->out);
+}
+
+// Start printing 'x', the remainder of a split at 'level + 1', on another
+// thread. The thread gets a converter of its own, which shares the power
+// cache, since it is only ever read, but has its own quotients, remainders,
+// and digit buffer for every level up to 'level'.
+static int emit_fork(struct emit_task* task, const struct converter* parent, const mpz_t x, ssize_t level, size_t after, size_t threads) {
+    struct converter* conv = &task->conv;
+    size_t levels = (size_t) (level + 1);
+
+    task->x = x;
+    task->level = level;
+    task->after = after;
+    task->collect_stats = (thread_stats != NULL);
+
+    conv->from = parent->from;
+    conv->to = parent->to;
+    conv->out = &task->out;
+    conv->grouping = parent->grouping;
+    conv->pretty_print = parent->pretty_print;
+    conv->format = parent->format;
+    conv->invalid = FALSE;
+    conv->threads = threads;
+    conv->digits = NULL;
+    conv->digits_capacity = 0;
+    conv->powers = parent->powers;
+    conv->quotients = malloc(levels * sizeof (mpz_t));
+    conv->remainders = malloc(levels * sizeof (mpz_t));
+    conv->levels = 0;
+
+    // The numbers are resized by the new thread, so none of them may come
+    // from the arena of this one.
+    int arena_active = arena_suspend();
+
+    mpz_init(conv->scratch);
+
+    if ((output_init(&task->out, -1, 0, FALSE) == FAILURE) || (conv->quotients == NULL)
+        || (conv->remainders == NULL) || (reserve_digits(conv, EMIT_CHUNK_DIGITS) == FAILURE)) {
+        emit_task_clear(task);
+        arena_resume(arena_active);
+        return FAILURE;
+    }
+
+    for ( ; conv->levels < levels; ++conv->levels) {
+        mpz_init(conv->quotients[conv->levels]);
+        mpz_init(conv->remainders[conv->levels]);
+    }
+
+    arena_resume(arena_active);
+
+    if (pthread_create(&task->thread, NULL, emit_task_main, task) != 0) {
+        emit_task_clear(task);
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+// Emit 'x' just like 'emit_split', but while this thread prints the high half
+// of every large enough split, another thread prints the low half into
+// memory, which is then written out right after the high half. The threads
+// available are divided evenly between both halves.
+static void emit_split_parallel(struct converter* conv, const mpz_t x, ssize_t level, int padded, size_t after) {
+    if ((conv->threads < 2) || (level < 0) || (((size_t) EMIT_CHUNK_DIGITS << level) < PARALLEL_EMIT_DIGITS)) {
+        emit_split(conv, x, level, padded, after);
+        return;
+    }
+
+    if (!emit_divide(conv, x, (size_t) level, padded)) {
+        emit_split_parallel(conv, x, level - 1, FALSE, after);
+        return;
+    }
+
+    size_t low_digits = (size_t) EMIT_CHUNK_DIGITS << level;
+    size_t threads = conv->threads;
+
+    struct emit_task task;
+
+    if (emit_fork(&task, conv, conv->remainders[level], level - 1, after, threads / 2) == FAILURE) {
+        emit_split_parallel(conv, conv->quotients[level], level - 1, padded, after + low_digits);
+        emit_split_parallel(conv, conv->remainders[level], level - 1, TRUE, after);
+        return;
+    }
+
+    conv->threads = threads - threads / 2;
+    emit_split_parallel(conv, conv->quotients[level], level - 1, padded, after + low_digits);
+    conv->threads = threads;
+
+    pthread_join(task.thread, NULL);
+
+    if (task.collect_stats) {
+        stats_merge(thread_stats, &task.stats);
+    }
+
+    if (task.out.error) {
+        conv->out->error = TRUE;
+    } else {
+        output_write(conv->out, task.out.buffer, task.out.size);
+    }
+
+    emit_task_clear(&task);
+}
+
+// Write the decimal digits of 'x' backwards from 'end', and return a pointer
+// to the first digit.
+static char* format_u64(uint64_t x, char* end) {
+    while (x >= 100) {
+        end -= 2;
+        memcpy(end, digit_pairs + (x % 100) * 2, 2);
+        x /= 100;
+    }
+
+    if (x >= 10) {
+        end -= 2;
+        memcpy(end, digit_pairs + x * 2, 2);
+    } else {
+        *--end = (char) ('0' + x);
+    }
+
+    return end;
+}
+
+// Write the digits of 'x' in a base that is not a power of two backwards
+// from 'end', and return a pointer to the first digit.
+static char* format_chunk(uint64_t x, int radix, char* end) {
+    if (radix == 10) {
+        return format_u64(x, end);
+    }
+
+    do {
+        *--end = digit_chars[x % (uint64_t) radix];
+        x /= (uint64_t) radix;
+    } while (x > 0);
+
+    return end;
+}
+
+void emit_uint(struct converter* conv, fast_uint x) {
+    // The largest 128-bit value has 128 binary digits.
+    char buffer[128];
+    char* end = buffer + sizeof buffer;
+    char* first;
+
+    const struct base* base = conv->to;
+
+    // The digits of a power of two are read directly off the bits.
+    if (base->bits) {
+        const fast_uint mask = ((fast_uint) 1 << base->bits) - 1;
+
+        first = end;
+
+        do {
+            *--first = digit_chars[(size_t) (x & mask)];
+            x >>= base->bits;
+        } while (x > 0);
+
+        emit_digits(conv, first, (size_t) (end - first), 0);
+        return;
+    }
+
+    #if defined(__SIZEOF_INT128__)
+    // Split off the low chunk of digits, which always fits in a 64-bit
+    // integer, so that only a couple of 128-bit divisions are needed. For
+    // base 10, a chunk is 19 digits, and there are at most two divisions.
+    while (x > UINT64_MAX) {
+        first = format_chunk((uint64_t) (x % base->chunk_base), base->radix, end);
+
+        // Pad the low part to its full width with leading zeros.
+        while (first > end - base->chunk_digits) {
+            *--first = '0';
+        }
+
+        end = first;
+        x /= base->chunk_base;
+    }
+    #endif // __SIZEOF_INT128__
+
+    first = format_chunk((uint64_t) x, base->radix, end);
+
+    emit_digits(conv, first, (size_t) (buffer + sizeof buffer - first), 0);
+}
+
+// Emit 'x' in a base that is a power of two, where every digit is a group of
+// bits of a single limb, or of two adjacent limbs, so the digits are read
+// directly off the limbs, from the most significant, a chunk at a time.
+static int emit_bits(struct converter* conv, const mpz_t x) {
+    // This is always the exact number of digits for a power of two.
+    size_t count = mpz_sizeinbase(x, conv->to->radix);
+
+    if (reserve_digits(conv, EMIT_CHUNK_DIGITS) == FAILURE) {
+        return FAILURE;
+    }
+
+    const mp_limb_t* limbs = mpz_limbs_read(x);
+    const size_t size = mpz_size(x);
+    const unsigned bits = (unsigned) conv->to->bits;
+    const mp_limb_t mask = ((mp_limb_t) 1 << bits) - 1;
+
+    for (size_t left = count; left > 0; ) {
+        size_t run = (left < EMIT_CHUNK_DIGITS) ? left : EMIT_CHUNK_DIGITS;
+
+        for (size_t j = 0; j < run; ++j) {
+            size_t position = (left - 1 - j) * bits;
+            size_t index = position / GMP_NUMB_BITS;
+            unsigned offset = (unsigned) (position % GMP_NUMB_BITS);
+
+            mp_limb_t value = (index < size) ? limbs[index] >> offset : 0;
+
+            if ((offset + bits > GMP_NUMB_BITS) && (index + 1 < size)) {
+                value |= limbs[index + 1] << (GMP_NUMB_BITS - offset);
+            }
+
+            conv->digits[j] = digit_chars[value & mask];
+        }
+
+        left -= run;
+        emit_digits(conv, conv->digits, run, left);
+    }
+
+    return SUCCESS;
+}
+
+int emit_mpz(struct converter* conv, const mpz_t x) {
+    if (conv->to->bits) {
+        return emit_bits(conv, x);
+    }
+
+    // This is either the exact number of digits, or one too many.
+    size_t digits = mpz_sizeinbase(x, conv->to->radix);
+
+    if (digits <= EMIT_DIRECT_DIGITS) {
+        if (reserve_digits(conv, digits) == FAILURE) {
+            return FAILURE;
+        }
+
+        emit_chunk(conv, x, 0, 0);
+
+        return SUCCESS;
+    }
+
+    // Find the smallest power of the base in the cache greater than the
+    // number, and split the number by the one right below it, which is the
+    // largest power the split ever divides by. The greater power is never
+    // computed, since it is only needed to bound the number, and squaring
+    // the largest power in the cache is the most expensive multiplication
+    // the emitter would ever do.
+    ssize_t level = -1;
+
+    while (((size_t) EMIT_CHUNK_DIGITS << (level + 1)) < digits) {
+        ++level;
+    }
+
+    if (reserve_digits(conv, EMIT_CHUNK_DIGITS) == FAILURE) {
+        return FAILURE;
+    }
+
+    if ((level >= 0) && (reserve_powers(conv, (size_t) level) == FAILURE)) {
+        return FAILURE;
+    }
+
+    emit_split_parallel(conv, x, level, FALSE, 0);
+
+    return SUCCESS;
+}
+
+int emit_binary_uint(struct converter* conv, fast_uint x) {
+    size_t count = 0;
+
+    for (fast_uint y = x; y > 0; y >>= 8) {
+        ++count;
+    }
+
+    if (conv->format == FORMAT_U64) {
+        if (count > 8) {
+            conv->invalid = INVALID_RANGE;
+            return FAILURE;
+        }
+
+        unsigned char* record = (unsigned char*) output_reserve(conv->out, 8);
+
+        if (record == NULL) {
+            return FAILURE;
+        }
+
+        store_le(record, x, 8);
+        output_commit(conv->out, 8);
+
+        return SUCCESS;
+    }
+
+    unsigned char* record = (unsigned char*) output_reserve(conv->out, 4 + count);
+
+    if (record == NULL) {
+        return FAILURE;
+    }
+
+    store_le(record, count, 4);
+    store_le(record + 4, x, count);
+    output_commit(conv->out, 4 + count);
+
+    return SUCCESS;
+}
+
+int emit_binary_mpz(struct converter* conv, const mpz_t x) {
+    size_t count = (mpz_sgn(x) == 0) ? 0 : (mpz_sizeinbase(x, 2) + 7) / 8;
+
+    if (conv->format == FORMAT_U64) {
+        if (count > 8) {
+            conv->invalid = INVALID_RANGE;
+            return FAILURE;
+        }
+
+        unsigned char* record = (unsigned char*) output_reserve(conv->out, 8);
+
+        if (record == NULL) {
+            return FAILURE;
+        }
+
+        memset(record, 0, 8);
+        mpz_export(record, NULL, -1, 1, 0, 0, x);
+        output_commit(conv->out, 8);
+
+        return SUCCESS;
+    }
+
+    if (count >= BINARY_INVALID) {
+        fprintf(stderr, "[Error] Number too large for the binary format (%zu bytes)\n", count);
+        return FAILURE;
+    }
+
+    unsigned char* header = (unsigned char*) output_reserve(conv->out, 4);
+
+    if (header == NULL) {
+        return FAILURE;
+    }
+
+    store_le(header, count, 4);
+    output_commit(conv->out, 4);
+
+    #if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    // Without nails, the limbs of the number already are its bytes, least
+    // significant first, on a little-endian machine, so they are written
+    // out directly, without copying giant numbers into the buffer first.
+    if (GMP_NAIL_BITS == 0) {
+        return output_write(conv->out, mpz_limbs_read(x), count);
+    }
+    #endif // __BYTE_ORDER__
+
+    unsigned char* bytes = (unsigned char*) output_reserve(conv->out, count);
+
+    if (bytes == NULL) {
+        return FAILURE;
+    }
+
+    mpz_export(bytes, NULL, -1, 1, 0, 0, x);
+    output_commit(conv->out, count);
+
+    return SUCCESS;
+}
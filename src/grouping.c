@@ -0,0 +1,173 @@
+
+#include "hex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                GROUPING.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This file contains the digit grouping used when pretty-printing.
+ *          The locale's grouping specification and thousands separator are
+ *          resolved once, at startup, into a formatting plan, which is then
+ *          used to insert the separators into every number in a single pass.
+ *
+ *          The plan supports the full 'grouping' specification from the
+ *          locale, so that groups of different sizes, such as the Indian
+ *          3;2 grouping (12,34,56,789), are formatted correctly.
+ *
+ *  **************************************************************************/
+
+// In case the locale does not specify a grouping at all, the digits are
+// grouped in groups of DEFAULT_DIGITS_PER_GROUP, which may be overridden when
+// compiling like so:
+//
+//      -DDEFAULT_DIGITS_PER_GROUP=4
+
+#ifndef DEFAULT_DIGITS_PER_GROUP
+#define DEFAULT_DIGITS_PER_GROUP 3
+#endif // DEFAULT_DIGITS_PER_GROUP
+
+void grouping_init(struct grouping* plan, const struct lconv* lc) {
+    plan->count = 0;
+    plan->repeat = 0;
+    plan->separator_length = 0;
+
+    // Keep a copy of the separator, since the locale information may be
+    // overwritten by later calls to 'localeconv'. A separator too long to be
+    // a single character in any encoding is ignored.
+    size_t separator_length = strlen(lc->thousands_sep);
+
+    if (separator_length < sizeof plan->separator) {
+        memcpy(plan->separator, lc->thousands_sep, separator_length + 1);
+        plan->separator_length = separator_length;
+    }
+
+    // Without a separator, grouping the digits would make no difference.
+    if (plan->separator_length == 0) {
+        return;
+    }
+
+    // Each element of the grouping string is the size of the next group to
+    // the left. The last size repeats indefinitely if the string simply
+    // ends, but grouping stops altogether at CHAR_MAX, or at any value that
+    // is not a valid group size.
+    size_t boundary = 0;
+    size_t size = 0;
+    const char* g = lc->grouping;
+
+    for ( ; (*g != '\0') && (plan->count < GROUPING_MAX_GROUPS); ++g) {
+        if ((*g == CHAR_MAX) || (*g <= 0)) {
+            return;
+        }
+
+        size = (size_t) *g;
+        boundary += size;
+        plan->boundaries[plan->count++] = boundary;
+    }
+
+    if (plan->count == 0) {
+        size = DEFAULT_DIGITS_PER_GROUP;
+        plan->boundaries[plan->count++] = size;
+    }
+
+    plan->repeat = size;
+}
+
+size_t grouping_boundary(const struct grouping* plan, size_t right) {
+    if (plan->count == 0) {
+        return 0;
+    }
+
+    size_t last = plan->boundaries[plan->count - 1];
+
+    if (right >= last) {
+        if (plan->repeat == 0) {
+            return last;
+        }
+
+        return last + ((right - last) / plan->repeat) * plan->repeat;
+    }
+
+    size_t boundary = 0;
+
+    for (size_t i = 0; (i < plan->count) && (plan->boundaries[i] <= right); ++i) {
+        boundary = plan->boundaries[i];
+    }
+
+    return boundary;
+}
+
+// Number of separators that follow a digit with at most 'right' digits after
+// it, not counting the last digit, which has none.
+static size_t grouping_count(const struct grouping* plan, size_t right) {
+    if (plan->count == 0) {
+        return 0;
+    }
+
+    size_t last = plan->boundaries[plan->count - 1];
+
+    if (right >= last) {
+        size_t count = plan->count;
+
+        if (plan->repeat) {
+            count += (right - last) / plan->repeat;
+        }
+
+        return count;
+    }
+
+    size_t count = 0;
+
+    while ((count < plan->count) && (plan->boundaries[count] <= right)) {
+        ++count;
+    }
+
+    return count;
+}
+
+size_t grouping_length(const struct grouping* plan, size_t count, size_t after) {
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t separators = grouping_count(plan, after + count - 1);
+
+    if (after > 0) {
+        separators -= grouping_count(plan, after - 1);
+    }
+
+    return count + separators * plan->separator_length;
+}
+
+char* grouping_format(const struct grouping* plan, const char* digits, size_t count, size_t after, char* dst) {
+    while (count > 0) {
+        // Find the separator closest to the next digit, counting the digits
+        // to its right, and copy every digit up to it in one go.
+        size_t right = after + count - 1;
+        size_t boundary = grouping_boundary(plan, right);
+
+        if ((boundary == 0) || (boundary < after)) {
+            memcpy(dst, digits, count);
+            return dst + count;
+        }
+
+        size_t run = right - boundary + 1;
+
+        memcpy(dst, digits, run);
+        dst += run;
+        digits += run;
+        count -= run;
+
+        memcpy(dst, plan->separator, plan->separator_length);
+        dst += plan->separator_length;
+    }
+
+    return dst;
+}
@@ -0,0 +1,283 @@
+
+#include "hex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                INPUT.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This file contains the streaming input reader, which splits the
+ *          contents of a file, or of standard input, into whitespace-
+ *          separated tokens. Regular files are memory-mapped, and anything
+ *          else, like a pipe, is read in large chunks directly with 'read'.
+ *          Either way, every token is handed to the converter in place,
+ *          without copying it or terminating it.
+ *
+ *  **************************************************************************/
+
+// Number of bytes requested from the operating system per read. The buffer
+// only grows beyond this size if a single token does not fit in it.
+
+#ifndef INPUT_CHUNK_SIZE
+#define INPUT_CHUNK_SIZE (1 << 20)
+#endif // INPUT_CHUNK_SIZE
+
+static inline int is_separator(char c) {
+    return (c == ' ') || ((c >= '\t') && (c <= '\r'));
+}
+
+// Map the whole file into memory, if it is a regular file. The mapping is
+// then the input buffer, and since it already holds the entire file, there
+// is never anything else to read. The pages are only read in as the tokens
+// are scanned, so memory use is bounded by the page cache rather than by
+// the size of the file.
+//
+// Standard input may be a file someone else has already read part of, in
+// which case only the rest of it is ours to read. Such files are read like
+// any other stream, so that nothing before the current position is read
+// again, and the offsets of the inputs still count from where we started.
+static int input_map(struct input* in) {
+    struct stat st;
+
+    if ((fstat(in->fd, &st) == -1) || !S_ISREG(st.st_mode) || (st.st_size <= 0)) {
+        return FAILURE;
+    }
+
+    if (lseek(in->fd, 0, SEEK_CUR) != 0) {
+        return FAILURE;
+    }
+
+    if ((uintmax_t) st.st_size > SIZE_MAX) {
+        return FAILURE;
+    }
+
+    void* map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, in->fd, 0);
+
+    if (map == MAP_FAILED) {
+        return FAILURE;
+    }
+
+    madvise(map, (size_t) st.st_size, MADV_SEQUENTIAL);
+
+    in->buffer = map;
+    in->capacity = (size_t) st.st_size;
+    in->end = in->capacity;
+    in->eof = TRUE;
+    in->mapped = TRUE;
+
+    return SUCCESS;
+}
+
+int input_open(struct input* in, const char* path) {
+    in->name = path;
+    in->buffer = NULL;
+    in->capacity = 0;
+    in->start = 0;
+    in->end = 0;
+    in->offset = 0;
+    in->eof = FALSE;
+    in->error = FALSE;
+    in->mapped = FALSE;
+
+    // By convention, a single dash is the name for standard input.
+    if (strcmp(path, "-") == 0) {
+        in->name = "<stdin>";
+        in->fd = STDIN_FILENO;
+    } else {
+        in->fd = open(path, O_RDONLY);
+
+        if (in->fd == -1) {
+            fprintf(stderr, "[Error] Could not open file: %s (%s)\n", path, strerror(errno));
+            return FAILURE;
+        }
+    }
+
+    if (input_map(in) == SUCCESS) {
+        return SUCCESS;
+    }
+
+    in->buffer = malloc(INPUT_CHUNK_SIZE);
+
+    if (in->buffer == NULL) {
+        fprintf(stderr, "[Error] Failed to allocate input buffer for %s\n", in->name);
+        input_close(in);
+        return FAILURE;
+    }
+
+    in->capacity = INPUT_CHUNK_SIZE;
+
+    return SUCCESS;
+}
+
+void input_close(struct input* in) {
+    if ((in->fd != STDIN_FILENO) && (in->fd != -1)) {
+        close(in->fd);
+    }
+
+    if (in->mapped) {
+        munmap(in->buffer, in->capacity);
+    } else {
+        free(in->buffer);
+    }
+
+    in->fd = -1;
+    in->buffer = NULL;
+}
+
+int input_fill(struct input* in) {
+    if (in->start > 0) {
+        memmove(in->buffer, in->buffer + in->start, in->end - in->start);
+
+        in->offset += in->start;
+        in->end -= in->start;
+        in->start = 0;
+    }
+
+    if (in->end == in->capacity) {
+        char* buffer = realloc(in->buffer, in->capacity * 2);
+
+        if (buffer == NULL) {
+            fprintf(stderr, "[Error] Failed to grow input buffer for %s\n", in->name);
+            in->error = TRUE;
+            return FAILURE;
+        }
+
+        in->buffer = buffer;
+        in->capacity *= 2;
+    }
+
+    ssize_t bytes;
+
+    do {
+        bytes = read(in->fd, in->buffer + in->end, in->capacity - in->end);
+    } while ((bytes == -1) && (errno == EINTR));
+
+    if (bytes == -1) {
+        fprintf(stderr, "[Error] Failed to read from %s (%s)\n", in->name, strerror(errno));
+        in->error = TRUE;
+        return FAILURE;
+    }
+
+    if (bytes == 0) {
+        in->eof = TRUE;
+    }
+
+    in->end += (size_t) bytes;
+
+    return SUCCESS;
+}
+
+int input_next_token(struct input* in, const char** token, size_t* len) {
+    // Number of token characters already scanned before the last refill, so
+    // that they do not need to be scanned again.
+    size_t scanned = 0;
+
+    for (;;) {
+        while ((in->start < in->end) && is_separator(in->buffer[in->start])) {
+            ++in->start;
+        }
+
+        if (in->start == in->end) {
+            if (in->eof || (input_fill(in) == FAILURE)) {
+                return FALSE;
+            }
+
+            continue;
+        }
+
+        size_t i = in->start + scanned;
+
+        while ((i < in->end) && !is_separator(in->buffer[i])) {
+            ++i;
+        }
+
+        // The token may continue in the next chunk, unless this is the end of
+        // the input.
+        if ((i == in->end) && !in->eof) {
+            scanned = i - in->start;
+
+            if (input_fill(in) == FAILURE) {
+                return FALSE;
+            }
+
+            continue;
+        }
+
+        *token = in->buffer + in->start;
+        *len = i - in->start;
+
+        in->start = i;
+
+        return TRUE;
+    }
+}
+
+// Get the next token, measuring the time spent reading the input.
+static int next_token(struct input* in, const char** token, size_t* len) {
+    int previous = stats_stage(STAGE_INPUT);
+    int found = input_next_token(in, token, len);
+
+    stats_stage(previous);
+
+    return found;
+}
+
+int convert_file(struct converter* conv, struct pool* pool, const char* path) {
+    struct input in;
+
+    int previous = stats_stage(STAGE_INPUT);
+    int opened = input_open(&in, path);
+
+    stats_stage(previous);
+
+    if (opened == FAILURE) {
+        return FAILURE;
+    }
+
+    const char* token;
+    size_t len;
+
+    if (pool) {
+        // Tokens in a memory mapping remain valid until it is unmapped, so
+        // only the ones in the read buffer, which is reused, are copied.
+        int result = SUCCESS;
+
+        while ((result == SUCCESS) && next_token(&in, &token, &len)) {
+            result = pool_convert(pool, token, len, in.offset + (uint64_t) (token - in.buffer), !in.mapped);
+        }
+
+        if ((pool_drain(pool) == FAILURE) || (in.error == TRUE)) {
+            result = FAILURE;
+        }
+
+        input_close(&in);
+
+        return result;
+    }
+
+    // The inputs are numbered across every file, so that an input can be
+    // found in the results by its number, unless invalid inputs are skipped.
+    while (next_token(&in, &token, &len)) {
+        if (convert_input(conv, token, len, ++conv->tokens, in.offset + (uint64_t) (token - in.buffer)) == FAILURE) {
+            if (conv->invalid) {
+                report_invalid_token(conv->invalid, conv->invalid_index, conv->invalid_offset);
+            }
+
+            input_close(&in);
+            return FAILURE;
+        }
+    }
+
+    int result = (in.error == TRUE) ? FAILURE : SUCCESS;
+
+    input_close(&in);
+
+    return result;
+}
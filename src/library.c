@@ -0,0 +1,184 @@
+
+#include "hex2dec.h"
+#include "libhex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                LIBRARY.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This file contains the public interface of libhex2dec, which
+ *          lets other programs use the conversion engine in-process rather
+ *          than running the hex2dec program for every conversion.
+ *
+ *          A context wraps the same converter used by the program, along
+ *          with an in-memory output the results are assembled in before they
+ *          are copied to the caller's buffer. A result that does not fit in
+ *          the caller's buffer is kept there, so that the call can be
+ *          repeated with a larger buffer without converting the number
+ *          again.
+ *
+ *  **************************************************************************/
+
+struct hex2dec_context {
+    struct converter conv;
+    struct output out;
+    struct grouping grouping;
+
+    // The input whose result is still in the output, waiting for a buffer
+    // large enough, if 'has_pending' is set.
+    char* pending;
+    size_t pending_length;
+    size_t pending_capacity;
+    int has_pending;
+};
+
+hex2dec_context* hex2dec_context_new(void) {
+    hex2dec_context* ctx = malloc(sizeof (hex2dec_context));
+
+    if (ctx == NULL) {
+        return NULL;
+    }
+
+    if (output_init(&ctx->out, -1, 0, FALSE) == FAILURE) {
+        free(ctx);
+        return NULL;
+    }
+
+    converter_init(&ctx->conv);
+    ctx->conv.out = &ctx->out;
+
+    ctx->pending = NULL;
+    ctx->pending_length = 0;
+    ctx->pending_capacity = 0;
+    ctx->has_pending = FALSE;
+
+    return ctx;
+}
+
+void hex2dec_context_free(hex2dec_context* ctx) {
+    if (ctx == NULL) {
+        return;
+    }
+
+    converter_clear(&ctx->conv);
+    output_free(&ctx->out);
+
+    free(ctx->pending);
+    free(ctx);
+}
+
+void hex2dec_context_set_locale(hex2dec_context* ctx, const struct lconv* lc) {
+    ctx->has_pending = FALSE;
+
+    if (lc == NULL) {
+        ctx->conv.grouping = NULL;
+        return;
+    }
+
+    grouping_init(&ctx->grouping, lc);
+    ctx->conv.grouping = &ctx->grouping;
+}
+
+void hex2dec_context_set_threads(hex2dec_context* ctx, size_t threads) {
+    ctx->conv.threads = (threads > 0) ? threads : 1;
+}
+
+int hex2dec_context_set_bases(hex2dec_context* ctx, int from, int to) {
+    const struct base* from_base = base_info(from);
+    const struct base* to_base = base_info(to);
+
+    if ((from_base == NULL) || (to_base == NULL)) {
+        return HEX2DEC_INVALID;
+    }
+
+    ctx->has_pending = FALSE;
+
+    // The cached powers are powers of the output base, so they are dropped
+    // whenever it changes.
+    if (to_base != ctx->conv.to) {
+        emit_clear(&ctx->conv);
+    }
+
+    ctx->conv.from = from_base;
+    ctx->conv.to = to_base;
+
+    return HEX2DEC_OK;
+}
+
+// Keep a copy of the input whose result is waiting in the output for a
+// larger buffer. If there is not enough memory for it, the retry simply
+// converts the number again.
+static void keep_pending(hex2dec_context* ctx, const char* in, size_t len) {
+    if (ctx->pending_capacity < len) {
+        char* pending = realloc(ctx->pending, len);
+
+        if (pending == NULL) {
+            return;
+        }
+
+        ctx->pending = pending;
+        ctx->pending_capacity = len;
+    }
+
+    memcpy(ctx->pending, in, len);
+
+    ctx->pending_length = len;
+    ctx->has_pending = TRUE;
+}
+
+int hex2dec_convert(hex2dec_context* ctx, const char* in, size_t len, char* out, size_t cap, size_t* out_len) {
+    size_t start;
+    size_t end;
+
+    // A retry with a larger buffer is served from the result of the call
+    // that did not fit, which is still in the output, as long as it is for
+    // the same input.
+    int retry = ctx->has_pending && (len == ctx->pending_length) && ((len == 0) || (memcmp(in, ctx->pending, len) == 0));
+
+    ctx->has_pending = FALSE;
+
+    if (!retry) {
+        if (digit_span(ctx->conv.from, in, len, &start, &end, out_len) == FAILURE) {
+            return HEX2DEC_INVALID;
+        }
+
+        // The output only ever grows, so once it fits the largest result,
+        // every conversion reuses it as is.
+        ctx->out.size = 0;
+        ctx->out.error = FALSE;
+
+        if ((convert_value(&ctx->conv, in + start, end - start) == FAILURE) || ctx->out.error) {
+            return HEX2DEC_NO_MEMORY;
+        }
+    }
+
+    *out_len = ctx->out.size;
+
+    if (ctx->out.size > cap) {
+        keep_pending(ctx, in, len);
+        return HEX2DEC_BUFFER_TOO_SMALL;
+    }
+
+    memcpy(out, ctx->out.buffer, ctx->out.size);
+
+    return HEX2DEC_OK;
+}
+
+const char* hex2dec_strerror(int status) {
+    switch (status) {
+        case HEX2DEC_OK: return "Success";
+        case HEX2DEC_INVALID: return "Invalid value in number";
+        case HEX2DEC_BUFFER_TOO_SMALL: return "Output buffer too small";
+        case HEX2DEC_NO_MEMORY: return "Out of memory";
+    }
+
+    return "Unknown error";
+}
@@ -19,11 +19,10 @@
  *
  *  **************************************************************************/
 
-int is_valid_num(char c);
-int is_valid_hex_alpha_upper(char c);
-int is_valid_hex_alpha_lower(char c);
-int is_valid_hex_alpha(char c);
-int is_valid_hex(char c);
+int is_option(const char* arg);
+int option_with_value(int argc, char* argv[], int* i, const char* short_name, const char* long_name, const char** value);
+int parse_size(const char* str, size_t* size);
+int parse_base(const char* str, const struct base** base);
 
 void print_license_info(void);
 void print_version_info(void);
@@ -54,6 +53,29 @@ int main(int argc, char *argv[])
     // Available program options
     int option_print_with_locale_formatting = FALSE;
     int option_verbose_output = FALSE;
+    int option_read_from_files = FALSE;
+    int option_line_buffered = isatty(STDOUT_FILENO);
+    size_t option_buffer_size = OUTPUT_BUFFER_SIZE;
+    size_t option_jobs = 1;
+    int option_server = FALSE;
+    int option_stats = FALSE;
+    int option_scan = FALSE;
+    int option_scan_mode = SCAN_REPLACE;
+    int option_on_error = ON_ERROR_ABORT;
+    int option_format = FORMAT_TEXT;
+    const char* option_socket = NULL;
+    const struct base* option_from = base_info(16);
+    const struct base* option_to = base_info(10);
+
+    // Every argument that is not an option is an input, and they are all
+    // gathered at the front of the argument vector as the options are parsed.
+    // This is always safe because there can never be more inputs than there
+    // are arguments already checked.
+    char** inputs = argv + 1;
+    int input_count = 0;
+
+    // Value of the current option, for the options that take one.
+    const char* value = NULL;
     
     // Check for options
     // TODO: Add option to print in custom locale as specified via command line.
@@ -63,9 +85,10 @@ int main(int argc, char *argv[])
         // input strings will be handled by the numeric parser proper. Therefore,
         // Check if the input string begins if a dash. If it does, look for the
         // corresponding match. Otherwise, skip it.
-        if (argv[i][0] != '-') {
+        if (!is_option(argv[i])) {
             // Input string does not begin with a dash, so it is not an option.
-            // Skip input string by prematurely ending the current iteration.
+            // Save it as an input and skip to the next argument.
+            inputs[input_count++] = argv[i];
             continue;
         }
 
@@ -91,6 +114,105 @@ int main(int argc, char *argv[])
             option_print_with_locale_formatting = TRUE;
         } else if ((strcmp(argv[i],"-v") == 0) || (strcmp(argv[i],"--verbose") == 0)) {
             option_verbose_output = TRUE;
+        } else if ((strcmp(argv[i],"-f") == 0) || (strcmp(argv[i],"--files") == 0)) {
+            option_read_from_files = TRUE;
+        } else if (strcmp(argv[i],"--line-buffered") == 0) {
+            option_line_buffered = TRUE;
+        } else if (option_with_value(argc, argv, &i, NULL, "--buffer-size", &value)) {
+            if ((value == NULL) || (parse_size(value, &option_buffer_size) == FAILURE) || (option_buffer_size == 0)) {
+                fprintf(stderr, "[Error] Invalid buffer size: %s\n", value ? value : "(none)");
+
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i],"--stats") == 0) {
+            option_stats = TRUE;
+        } else if (strcmp(argv[i],"--server") == 0) {
+            option_server = TRUE;
+        } else if (option_with_value(argc, argv, &i, NULL, "--socket", &value)) {
+            // Listening on a socket implies the server mode.
+            if ((value == NULL) || (value[0] == '\0')) {
+                fprintf(stderr, "[Error] Missing socket path\n");
+
+                return EXIT_FAILURE;
+            }
+
+            option_server = TRUE;
+            option_socket = value;
+        } else if (option_with_value(argc, argv, &i, "-j", "--jobs", &value)) {
+            // Zero worker threads means one per processor.
+            if ((value == NULL) || (parse_size(value, &option_jobs) == FAILURE)) {
+                fprintf(stderr, "[Error] Invalid number of jobs: %s\n", value ? value : "(none)");
+
+                return EXIT_FAILURE;
+            }
+
+            if (option_jobs == 0) {
+                option_jobs = pool_default_threads();
+            }
+        } else if ((strcmp(argv[i],"--scan") == 0) || (strncmp(argv[i],"--scan=",7) == 0)) {
+            // The mode is optional, so it can only ever be attached to the
+            // option itself.
+            const char* mode = (argv[i][6] == '=') ? argv[i] + 7 : "replace";
+
+            if (strcmp(mode, "replace") == 0) {
+                option_scan_mode = SCAN_REPLACE;
+            } else if (strcmp(mode, "append") == 0) {
+                option_scan_mode = SCAN_APPEND;
+            } else {
+                fprintf(stderr, "[Error] Invalid scan mode: %s\n", mode);
+
+                return EXIT_FAILURE;
+            }
+
+            option_scan = TRUE;
+        } else if (option_with_value(argc, argv, &i, NULL, "--on-error", &value)) {
+            if (value == NULL) {
+                fprintf(stderr, "[Error] Invalid error policy: (none)\n");
+
+                return EXIT_FAILURE;
+            } else if (strcmp(value, "abort") == 0) {
+                option_on_error = ON_ERROR_ABORT;
+            } else if (strcmp(value, "skip") == 0) {
+                option_on_error = ON_ERROR_SKIP;
+            } else if (strcmp(value, "placeholder") == 0) {
+                option_on_error = ON_ERROR_PLACEHOLDER;
+            } else if (strcmp(value, "record") == 0) {
+                option_on_error = ON_ERROR_RECORD;
+            } else {
+                fprintf(stderr, "[Error] Invalid error policy: %s\n", value);
+
+                return EXIT_FAILURE;
+            }
+        } else if (option_with_value(argc, argv, &i, NULL, "--format", &value)) {
+            if (value == NULL) {
+                fprintf(stderr, "[Error] Invalid output format: (none)\n");
+
+                return EXIT_FAILURE;
+            } else if (strcmp(value, "text") == 0) {
+                option_format = FORMAT_TEXT;
+            } else if (strcmp(value, "binary") == 0) {
+                option_format = FORMAT_BINARY;
+            } else if (strcmp(value, "u64") == 0) {
+                option_format = FORMAT_U64;
+            } else if (strcmp(value, "ndjson") == 0) {
+                option_format = FORMAT_NDJSON;
+            } else {
+                fprintf(stderr, "[Error] Invalid output format: %s\n", value);
+
+                return EXIT_FAILURE;
+            }
+        } else if (option_with_value(argc, argv, &i, NULL, "--from", &value)) {
+            if ((value == NULL) || (parse_base(value, &option_from) == FAILURE)) {
+                fprintf(stderr, "[Error] Invalid input base: %s\n", value ? value : "(none)");
+
+                return EXIT_FAILURE;
+            }
+        } else if (option_with_value(argc, argv, &i, NULL, "--to", &value)) {
+            if ((value == NULL) || (parse_base(value, &option_to) == FAILURE)) {
+                fprintf(stderr, "[Error] Invalid output base: %s\n", value ? value : "(none)");
+
+                return EXIT_FAILURE;
+            }
         } else {
             // To allow the user to specify options wherever they wish (i.e., before
             // or after the inputs), we consider any input begining with a dash 
@@ -101,6 +223,78 @@ int main(int argc, char *argv[])
         }
     }
 
+    // In server mode, the numbers to convert come from the requests, and
+    // never from the command line.
+    if ((option_server == TRUE) && ((input_count > 0) || (option_read_from_files == TRUE) || (option_scan == TRUE))) {
+        fprintf(stderr, "[Error] No inputs may be given in server mode\n");
+
+        return EXIT_FAILURE;
+    }
+
+    // The server has its own protocol, and the scanner writes text, so the
+    // other formats only apply to numbers given as arguments or in files.
+    if ((option_format != FORMAT_TEXT) && ((option_server == TRUE) || (option_scan == TRUE))) {
+        fprintf(stderr, "[Error] Only the text format can be used in server and scan modes\n");
+
+        return EXIT_FAILURE;
+    }
+
+    if ((option_format != FORMAT_TEXT) && (option_print_with_locale_formatting == TRUE)) {
+        fprintf(stderr, "[Error] Only the text format can be pretty-printed\n");
+
+        return EXIT_FAILURE;
+    }
+
+    // Every u64 record is a value, so there is no way to mark an invalid
+    // input in its place.
+    if ((option_format == FORMAT_U64) && ((option_on_error == ON_ERROR_PLACEHOLDER) || (option_on_error == ON_ERROR_RECORD))) {
+        fprintf(stderr, "[Error] Invalid numbers can only be skipped in the u64 format\n");
+
+        return EXIT_FAILURE;
+    }
+
+    // Only hexadecimal numbers have a prefix or suffix that sets them apart
+    // from the rest of the text.
+    if ((option_scan == TRUE) && (option_from->radix != 16)) {
+        fprintf(stderr, "[Error] Only hexadecimal numbers can be scanned for\n");
+
+        return EXIT_FAILURE;
+    }
+
+    // GMP's memory must come from the memory functions from the very start,
+    // since memory from the system allocator must never be released to the
+    // arena, and vice versa. The statistics are also collected from the very
+    // start.
+    memory_install();
+
+    struct stats stats;
+    uint64_t start_time = 0;
+
+    if (option_stats == TRUE) {
+        stats_init(&stats);
+        thread_stats = &stats;
+        start_time = stats_now();
+    }
+
+    // The details printed in verbose mode go to standard output, except in
+    // server mode, where standard output carries the binary responses, and
+    // in the formats meant for other programs, which must only ever see the
+    // results.
+    FILE* verbose = ((option_server == TRUE) || (option_format != FORMAT_TEXT)) ? stderr : stdout;
+
+    // Select the hex decoding kernel up front, so the processor is only
+    // queried once, and let the user know which one was chosen.
+    const struct hex_kernel* kernel = hex_kernel();
+
+    if (option_verbose_output == TRUE) {
+        fprintf(verbose, "Hex decoding kernel: %s\n", kernel->name);
+        fprintf(verbose, "Conversion: base %d to base %d\n", option_from->radix, option_to->radix);
+
+        if (option_jobs > 1) {
+            fprintf(verbose, "Worker threads: %zu\n", option_jobs);
+        }
+    }
+
     // If pretty-printing enabled, set up locale-specific info
     if (option_print_with_locale_formatting == TRUE) {
         // Check the configured system locale by passing 0 as the locale category.
@@ -113,14 +307,14 @@ int main(int argc, char *argv[])
             // verbose output, as this may unnecessarily scare them into thinking
             // this is more serious than it is.
             if (option_verbose_output == TRUE) {
-                printf("System locale is NULL. Will attempt to use default.\n");
+                fprintf(verbose, "System locale is NULL. Will attempt to use default.\n");
             }
         } else {
             // If the user requested verbose output, print the system locale to 
             // standard output. It is safe to do so because we have verified that
             // the system_locale pointer is not NULL.
             if (option_verbose_output == TRUE) {
-                printf("System locale: %s\n", system_locale);
+                fprintf(verbose, "System locale: %s\n", system_locale);
             }
         }
 
@@ -175,8 +369,8 @@ int main(int argc, char *argv[])
             // user may be scared into thinking this is a bigger issue than it 
             // actually is.
             if (option_verbose_output == TRUE) {
-                printf("Could not set locale: %s\n", LOCALE);
-                printf("Defaulting to '%s'\n", default_locale);
+                fprintf(verbose, "Could not set locale: %s\n", LOCALE);
+                fprintf(verbose, "Defaulting to '%s'\n", default_locale);
             }
 
             // Retry setting the locale with the specified default.
@@ -204,7 +398,7 @@ int main(int argc, char *argv[])
         if (option_verbose_output == TRUE) {
             // This will crash the program if locale = NULL if we don't skip it
             // because we would then be dereferencing a NULL pointer.
-            printf("Locale set: %s\n", locale);
+            fprintf(verbose, "Locale set: %s\n", locale);
         }
 
         // Call 'localeconv' to retrieve locale settings such as thousands 
@@ -223,217 +417,240 @@ int main(int argc, char *argv[])
 
 SKIP: /* Safely prevented dereferencing NULL locale pointer */ ;
 
-    // Allocate and initialize arbitrary-precision integer to hold decimal
-    // value for conversion of any size hexadecimal number.
-    mpz_t n;
-    mpz_init(n);
-
-    // Process input
-    while (*++argv) {
-        // Before beginning to process the input in earnest, check the first 
-        // character. If it's a dash, consider it an option and skip it.
-        if ((*argv)[0] == '-') {
-            // Avoid processing the current input by simply skipping the execution
-            // of the current iteration. There is no need to manually advance the
-            // argument pointer, as the loop stop condition does this itself. 
-            // Otherwise, we would cause the program to skip two arguments.
-            continue;
-        }
+    // Everything printed so far went through the C library, so make sure it
+    // is all out before the results start being written.
+    fflush(stdout);
 
-        // To avoid allocating and deallocating the output variable on each
-        // iteration, simply reset its value to 0 at the start of each input-
-        // processing step.
-        mpz_set_ui(n, 0);
-
-        for (size_t i = 0; i < strlen(*argv); ++i) {
-            // Check for the initial prefix hex values sometimes have: '0x' or '0X'.
-            //  
-            // The check is performed by testing whether we're at the start
-            // of the string and the current character is a zero. If both
-            // conditions are true, the third check makes sure the next char
-            // is a lowercase 'x'. This check thus ensures that we're not
-            // skipping over a number that is just prefixed with a zero. While
-            // this program does not handle numbers in octal notation in its
-            // current form, implementing this would not be difficult, and in
-            // any case, it's just good practice to verify the entire prefix
-            // is there. 
-            //
-            // If the number is prefixed by a zero but the next char
-            // is not a lower case 'x', the current value will be multiplied
-            // by the valid hex character '0', resulting in a non-update to
-            // the value, after which the index counter 'i' will be 
-            // incremented, an invalid value will be found if it's there, and
-            // an error message will be posted.
-            //
-            // If a number is entered in octal notation, it will be interpreted
-            // as hex in the current version of the program.
-            if ((i == 0) && ((*argv)[i] == '0') && (((*argv)[i+1] == 'x') || ((*argv)[i+1] == 'X'))) {
-                ++i;
-                continue;
-            }
+    // All of the results are assembled in a single output buffer, which is
+    // flushed when it fills up, or after every line if the output is line-
+    // buffered, as it is by default when writing to a terminal.
+    struct output out;
 
-            if ((*argv)[i] == 'h' || (*argv)[i] == 'H') {
-                // If we hit the hex specifier we're done.
-                break;
-            }
+    if (output_init(&out, STDOUT_FILENO, option_buffer_size, option_line_buffered) == FAILURE) {
+        return EXIT_FAILURE;
+    }
 
-            if (is_valid_hex_alpha_upper((*argv)[i])) {
-                mpz_mul_si(n, n, 16);
-                mpz_add_ui(n, n, (unsigned long int) (*argv)[i] - 'A' + 10);
+    // The converter holds the arbitrary-precision integer, along with the
+    // output settings, and it is reused for every input.
+    struct converter conv;
+    converter_init(&conv);
 
-                continue;
-            }
+    conv.from = option_from;
+    conv.to = option_to;
+    conv.out = &out;
+    conv.pretty_print = option_print_with_locale_formatting;
+    conv.threads = option_jobs;
+    conv.on_error = option_on_error;
+    conv.format = option_format;
 
-            if (is_valid_hex_alpha_lower((*argv)[i])) {
-                mpz_mul_si(n, n, 16);
-                mpz_add_ui(n, n, (unsigned long int) (*argv)[i] - 'a' + 10);
+    // Resolve the locale's digit grouping and separator once, rather than
+    // for every number.
+    struct grouping grouping;
 
-                continue;
-            }
+    if (option_print_with_locale_formatting == TRUE) {
+        grouping_init(&grouping, lc);
+        conv.grouping = &grouping;
+    }
 
-            if (is_valid_num((*argv)[i])) {
-                mpz_mul_si(n, n, 16);
-                mpz_add_ui(n, n, (unsigned long int) (*argv)[i] - '0');
+    // With more than one job, the inputs are converted by a pool of worker
+    // threads, each with a converter set up just like this one, while this
+    // thread writes the results out in order. The server and the scanner
+    // convert every number on this thread, splitting only giant numbers
+    // between threads.
+    struct pool workers;
+    struct pool* pool = NULL;
 
-                continue;
-            }
+    if ((option_jobs > 1) && (option_server == FALSE) && (option_scan == FALSE)) {
+        if (pool_init(&workers, option_jobs, &conv, &out) == FAILURE) {
+            converter_clear(&conv);
+            output_free(&out);
 
-            // Every valid character value explicitly continues the loop, so if 
-            // we hit this point, there are invalid characters, in the input. 
-            // More robust error handling would be nice, or maybe the option to
-            // simply skip invalid characters but for now simply exit with an
-            // error status.
-            fprintf(stderr, "[Error] Invalid value in number.\n");
             return EXIT_FAILURE;
         }
 
-        // Pretty print if specified via command-line option
-        if (option_print_with_locale_formatting == TRUE) {
-            
-            // Get number string by calling 'mpz_get_str'. The 'NULL' parameter
-            // means we are not supplying our own string. Instead, the function
-            // allocates the string on its own, but we must remember to free it,
-            // or else leak the allocated memory.
-            char* num_str = mpz_get_str(NULL, 10, n);
-            
-            // Get number of digits per digit group
-            errno = 0;
-
-            // In case something goes wrong or the locale setting specified a
-            // weird number of digits per group, set the number of digits per
-            // group to whatever the default is, as specified by the 
-            // DEFAULT_DIGITS_PER_GROUP variable.
-
-            #ifndef DEFAULT_DIGITS_PER_GROUP
-            #define DEFAULT_DIGITS_PER_GROUP 3
-            #endif // DEFAULT_DIGITS_PER_GROUP
-
-            long digits_per_group = strtol(lc->grouping, NULL, 10);
-
-            // Check for various possible errors that could have occurred during
-            // 'strtol' call.
-            if (((errno == ERANGE) && ((digits_per_group == LONG_MAX) || (digits_per_group == LONG_MIN))) || ((errno != 0) && (digits_per_group == 0))) {
-                // On failure, print the system error message by calling 'strerror'
-                // and print the 'lc->grouping' string so the user can see what the
-                // original string was.
-                fprintf(stderr, "[Error] Failed to get locale-specific number of digits per group: %s (%s) Defaulting to %d\n", lc->grouping, strerror(errno), DEFAULT_DIGITS_PER_GROUP);
-
-                // Set the number of digits_per_group to 0 so it can be fixed 
-                // down the line.
-                digits_per_group = 0;
+        pool = &workers;
+    }
+
+    int status = EXIT_SUCCESS;
+
+    // The server uses the converter set up above for every request, for as
+    // long as the client keeps the stream open, or until it is stopped when
+    // listening on a socket.
+    if (option_server == TRUE) {
+        if (option_socket) {
+            status = (serve_socket(&conv, option_socket) == FAILURE) ? EXIT_FAILURE : EXIT_SUCCESS;
+        } else {
+            status = (serve_stream(&conv, STDIN_FILENO, STDOUT_FILENO) == FAILURE) ? EXIT_FAILURE : EXIT_SUCCESS;
+        }
+    } else if (option_scan == TRUE) {
+        // Every input is the name of a file to scan, just as when reading
+        // from files, and standard input is scanned if there are none.
+        for (int i = 0; (i < input_count) && (status == EXIT_SUCCESS); ++i) {
+            if (scan_file(&conv, inputs[i], option_scan_mode) == FAILURE) {
+                status = EXIT_FAILURE;
             }
+        }
 
-            // Set digits_per_group to the previously established default if
-            // something went wrong.
-            if (digits_per_group == 0) {
-                digits_per_group = DEFAULT_DIGITS_PER_GROUP;
+        if ((input_count == 0) && (scan_file(&conv, "-", option_scan_mode) == FAILURE)) {
+            status = EXIT_FAILURE;
+        }
+    } else if (option_read_from_files == TRUE) {
+        // When reading from files, every input is the name of a file to read
+        // the numbers from, rather than a number itself. If no file names
+        // were given, the numbers are read from standard input.
+        for (int i = 0; (i < input_count) && (status == EXIT_SUCCESS); ++i) {
+            if (convert_file(&conv, pool, inputs[i]) == FAILURE) {
+                status = EXIT_FAILURE;
             }
-            
-            // Since we're parsing from left to right and adding separators, we
-            // need to make sure the left-most group only has a separator after
-            // the digits in a group if the whole number has a number of digits
-            // divisible by the number of digits in a group. Otherwise, with 
-            // numbers like 8022, we want the first group from left-to-right to 
-            // have a separator after the 8, not after the 802, yielding 802,2. 
-            // To do this, we set the initial number of digits in the current 
-            // group to the length of the string modulo three, giving us the 
-            // expected output.
-            long digits_in_group = 3 - (strlen(num_str) % digits_per_group);
-
-            // Print the original input string first
-            for (size_t i = 0; i < strlen(*argv); ++i) {
-                // Always print a lowercase 'x' for the hexadecimal prefix.
-                if ((*argv)[i] == 'x' || (*argv)[i] == 'X') {
-                    printf("x");
-                    continue;
-                }
+        }
 
-                // For every other character in the hexadecimal input string,
-                // make sure the alphanumeric characters are printed as upper-
-                // case, even if that is not how they were originally specified.
-                printf("%c", toupper((*argv)[i]));
+        if ((input_count == 0) && (convert_file(&conv, pool, "-") == FAILURE)) {
+            status = EXIT_FAILURE;
+        }
+    } else if (pool) {
+        // The arguments remain valid for the whole run, so they are never
+        // copied.
+        for (int i = 0; i < input_count; ++i) {
+            if (pool_convert(pool, inputs[i], strlen(inputs[i]), 0, FALSE) == FAILURE) {
+                break;
             }
+        }
 
-            // Print division ' = '
-            printf(" = ");
-
-            // Then print the converted string
-            for (size_t i = 0; i < strlen(num_str); ++i) {
-                
-                // Print a separator character after the requisite number of 
-                // digits in a group has been printed. Then reset the counter of
-                // digits in the current group, and continue printing digits,
-                // making sure to increase the number of digits in the current
-                // group.
-                if (digits_in_group == digits_per_group) {
-                    printf("%s", lc->thousands_sep);
-                    digits_in_group = 0;
+        if (pool_drain(pool) == FAILURE) {
+            status = EXIT_FAILURE;
+        }
+    } else {
+        // Process input. The offset of an invalid argument is that of the
+        // first invalid character in the argument itself.
+        for (int i = 0; i < input_count; ++i) {
+            if (convert_input(&conv, inputs[i], strlen(inputs[i]), ++conv.tokens, 0) == FAILURE) {
+                if (conv.invalid) {
+                    report_invalid_token(conv.invalid, conv.invalid_index, conv.invalid_offset);
                 }
 
-                printf("%c", num_str[i]);
-                ++digits_in_group;
+                status = EXIT_FAILURE;
+                break;
             }
-
-            // Free the memory allocated by 'mpz_get_str'.
-            free(num_str);
-        } else if (option_print_with_locale_formatting == FALSE) {
-            // Since the user did not request locale-specific formatting, simply
-            // use the built-in GMP printf function to print the number with no
-            // pomp and circumstance.
-            gmp_printf("%Zu", n);
         }
+    }
 
-        // Print a newline character after the number.
-        printf("\n");
+    // Write out whatever results are still buffered, even if there was an
+    // error, since every one of them is valid.
+    if (output_flush(&out) == FAILURE) {
+        status = EXIT_FAILURE;
     }
-        
+
+    // Rejected inputs do not stop the conversion, but the run still fails,
+    // so that they are never silently lost. Values too large for u64 are
+    // counted apart, since every one of their digits is valid.
+    uint64_t rejected_range = conv.rejected_range + (pool ? pool->rejected_range : 0);
+    uint64_t rejected = conv.rejected + (pool ? pool->rejected : 0) - rejected_range;
+
+    if (rejected > 0) {
+        fprintf(stderr, "[Error] Rejected %" PRIu64 " invalid number%s\n", rejected, (rejected == 1) ? "" : "s");
+
+        status = EXIT_FAILURE;
+    }
+
+    if (rejected_range > 0) {
+        fprintf(stderr, "[Error] Rejected %" PRIu64 " value%s that do%s not fit in u64\n", rejected_range, (rejected_range == 1) ? "" : "s", (rejected_range == 1) ? "es" : "");
+
+        status = EXIT_FAILURE;
+    }
+
+    if (pool) {
+        pool_free(pool);
+    }
+
     // Deallocate the output number only after all inputs have been processed.
     // This is an execution optimization that simply resets the value of the 
     // number at the start of each iteration, requiring only a single allocation
     // and deallocation at the start and end of the program, respectively.
-    mpz_clear(n);
+    converter_clear(&conv);
+    output_free(&out);
+    arena_free();
+
+    // The report goes to standard error, so that it never mixes with the
+    // results.
+    if (option_stats == TRUE) {
+        stats_stage(STAGE_OTHER);
+        stats_report(&stats, stats_now() - start_time, stderr);
+    }
 
-    return EXIT_SUCCESS;
+    return status;
 }
 
-int is_valid_num(char c) {
-    return ((c >= '0') && (c <= '9'));
+int is_option(const char* arg) {
+    // A lone dash is not an option, but rather the conventional name for
+    // standard input.
+    return (arg[0] == '-') && (arg[1] != '\0');
 }
 
-int is_valid_hex_alpha_upper(char c) {
-    return ((c >= 'A') && (c <= 'F'));
-}
+int option_with_value(int argc, char* argv[], int* i, const char* short_name, const char* long_name, const char** value) {
+    const char* arg = argv[*i];
+    size_t long_length = strlen(long_name);
 
-int is_valid_hex_alpha_lower(char c) {
-    return ((c >= 'a') && (c <= 'f'));
+    // The value may be attached to the option itself, as in '--name=value',
+    // or '-nvalue' for the short option, or it may be the next argument.
+    if ((strncmp(arg, long_name, long_length) == 0) && (arg[long_length] == '=')) {
+        *value = arg + long_length + 1;
+        return TRUE;
+    }
+
+    if (short_name && (strncmp(arg, short_name, 2) == 0) && (arg[2] != '\0')) {
+        *value = arg + 2;
+        return TRUE;
+    }
+
+    if ((strcmp(arg, long_name) == 0) || (short_name && (strcmp(arg, short_name) == 0))) {
+        *value = (*i + 1 < argc) ? argv[++*i] : NULL;
+        return TRUE;
+    }
+
+    return FALSE;
 }
 
-int is_valid_hex_alpha(char c) {
-    return is_valid_hex_alpha_upper(c) || is_valid_hex_alpha_lower(c);
+int parse_size(const char* str, size_t* size) {
+    char* end = NULL;
+
+    errno = 0;
+    unsigned long long number = strtoull(str, &end, 10);
+
+    if ((errno != 0) || (end == str) || (str[0] == '-')) {
+        return FAILURE;
+    }
+
+    // Allow the usual binary suffixes for kilobytes and megabytes.
+    unsigned long long multiplier = 1;
+
+    if ((*end == 'k') || (*end == 'K')) {
+        multiplier = 1ULL << 10;
+        ++end;
+    } else if ((*end == 'm') || (*end == 'M')) {
+        multiplier = 1ULL << 20;
+        ++end;
+    }
+
+    if ((*end != '\0') || (number > SIZE_MAX / multiplier)) {
+        return FAILURE;
+    }
+
+    *size = (size_t) (number * multiplier);
+
+    return SUCCESS;
 }
 
-int is_valid_hex(char c) {
-    return is_valid_num(c) || is_valid_hex_alpha(c);
+int parse_base(const char* str, const struct base** base) {
+    size_t radix;
+
+    // The base is a plain number, so the size suffixes are never allowed.
+    if ((parse_size(str, &radix) == FAILURE) || !isdigit((unsigned char) str[strlen(str) - 1]) || (radix > MAX_BASE)) {
+        return FAILURE;
+    }
+
+    *base = base_info((int) radix);
+
+    return (*base == NULL) ? FAILURE : SUCCESS;
 }
 
 void print_license_info(void) {
@@ -452,8 +669,46 @@ void print_version_info(void) {
 void print_help(void) {
     print_version_info();
 
-    printf("Usage: hex2dec [OPTIONS] NUMBER [NUMBERS...]\n\n");
+    printf("Usage: hex2dec [OPTIONS] NUMBER [NUMBERS...]\n");
+    printf("   or: hex2dec [OPTIONS] --files [FILE...]\n");
+    printf("   or: hex2dec [OPTIONS] --scan[=MODE] [FILE...]\n");
+    printf("   or: hex2dec [OPTIONS] --server [--socket=PATH]\n\n");
     printf("    -h, --help        Print this help menu and exit\n");
     printf("        --version     Print program version information and exit\n");
-    printf("    -v, --verbose     Print detailed info during execution\n\n");
+    printf("    -v, --verbose     Print detailed info during execution\n");
+    printf("    -f, --files       Read whitespace-separated numbers from the given files,\n");
+    printf("                      or from standard input if there are none or for '-'\n");
+    printf("        --scan[=MODE] Copy the text in the given files, or in standard input,\n");
+    printf("                      converting every '0x' number, and every 'h' number\n");
+    printf("                      starting with a digit, which are replaced by their\n");
+    printf("                      values if MODE is 'replace' (the default), or followed\n");
+    printf("                      by them in parentheses if it is 'append'\n");
+    printf("        --buffer-size=SIZE\n");
+    printf("                      Size of the output buffer in bytes (K and M suffixes\n");
+    printf("                      are allowed)\n");
+    printf("    -j, --jobs=N      Convert the inputs on N worker threads, or on one per\n");
+    printf("                      processor if N is 0 (default: 1); a single giant\n");
+    printf("                      number is also split between the threads\n");
+    printf("        --from=BASE   Read the numbers in BASE, from 2 to 36 (default: 16)\n");
+    printf("        --to=BASE     Print the numbers in BASE, from 2 to 36 (default: 10);\n");
+    printf("                      the digits are only grouped in base 10\n");
+    printf("        --on-error=POLICY\n");
+    printf("                      What to do with an invalid number: 'abort' the run\n");
+    printf("                      (the default), or 'skip' it, print a 'placeholder'\n");
+    printf("                      instead, or print a 'record' of its position instead,\n");
+    printf("                      and count it as rejected\n");
+    printf("        --format=FORMAT\n");
+    printf("                      Print the results as 'text' (the default), as 'binary'\n");
+    printf("                      values, each a 32-bit length followed by the bytes of\n");
+    printf("                      the value, as 'u64' values of exactly eight bytes, or\n");
+    printf("                      as 'ndjson' objects with the input and its value; the\n");
+    printf("                      binary values are little-endian\n");
+    printf("        --stats       Print the time spent in each stage, the input lengths,\n");
+    printf("                      and the GMP allocations to standard error at exit\n");
+    printf("        --server      Convert batches of numbers on request over standard\n");
+    printf("                      input and output, until the input is closed\n");
+    printf("        --socket=PATH Serve requests on the Unix domain socket at PATH\n");
+    printf("        --line-buffered\n");
+    printf("                      Write out every result as soon as it is ready, which\n");
+    printf("                      is the default when writing to a terminal\n\n");
 }
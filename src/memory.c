@@ -0,0 +1,287 @@
+
+#include "hex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                MEMORY.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This file contains the memory functions installed into GMP, which
+ *          serve the memory needed while converting a number from a per-
+ *          thread arena, rather than from the system allocator.
+ *
+ *          The arena is only used within a scope, which covers a single
+ *          conversion, and it is reset as a whole once the scope ends. Its
+ *          memory is handed out by bumping an offset, and since GMP releases
+ *          its temporaries in the reverse order it allocates them, memory
+ *          released from the top of the arena is immediately reused. Any
+ *          other memory released within the scope is simply reclaimed when
+ *          the scope ends.
+ *
+ *          Anything allocated outside of a scope, as well as any allocation
+ *          too large for the arena, comes from the system allocator, and
+ *          memory allocated by the system allocator is always resized and
+ *          released by it, even within a scope.
+ *
+ *  **************************************************************************/
+
+// Size of the first chunk of every arena. The arena grows by doubling, and
+// once the scope ends, only the largest chunk is kept.
+
+#ifndef ARENA_CHUNK_SIZE
+#define ARENA_CHUNK_SIZE (1 << 20)
+#endif // ARENA_CHUNK_SIZE
+
+// Allocations larger than this come from the system allocator, which maps
+// them directly anyway, as does everything once the arena reaches its
+// maximum size within a single scope.
+
+#ifndef ARENA_MAX_ALLOCATION
+#define ARENA_MAX_ALLOCATION (1 << 20)
+#endif // ARENA_MAX_ALLOCATION
+
+#ifndef ARENA_MAX_SIZE
+#define ARENA_MAX_SIZE (1 << 26)
+#endif // ARENA_MAX_SIZE
+
+#define ARENA_ALIGNMENT 16
+
+// Every chunk starts with a link to the chunk it replaced, which is kept
+// until the end of the scope, since memory in it may still be in use.
+struct chunk {
+    struct chunk* previous;
+    size_t capacity;
+};
+
+#define CHUNK_HEADER_SIZE ((sizeof (struct chunk) + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1))
+
+struct arena {
+    struct chunk* current;
+    char* base;
+    size_t capacity;
+    size_t top;
+    size_t total;
+    int active;
+};
+
+static _Thread_local struct arena arena = { NULL, NULL, 0, 0, 0, FALSE };
+
+static inline size_t align(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1);
+}
+
+static inline int chunk_owns(const struct chunk* chunk, const void* ptr) {
+    const char* base = (const char*) chunk + CHUNK_HEADER_SIZE;
+
+    return ((const char*) ptr >= base) && ((const char*) ptr < base + chunk->capacity);
+}
+
+int arena_owns(const void* ptr) {
+    for (const struct chunk* chunk = arena.current; chunk; chunk = chunk->previous) {
+        if (chunk_owns(chunk, ptr)) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+// Start a new chunk, large enough for 'size' bytes. The previous chunk is
+// retired, rather than freed, since its memory may still be in use.
+static int arena_grow(size_t size) {
+    size_t capacity = (arena.capacity > 0) ? arena.capacity * 2 : ARENA_CHUNK_SIZE;
+
+    while (capacity < size) {
+        capacity *= 2;
+    }
+
+    if (arena.total + capacity > ARENA_MAX_SIZE) {
+        return FAILURE;
+    }
+
+    struct chunk* chunk = malloc(CHUNK_HEADER_SIZE + capacity);
+
+    if (chunk == NULL) {
+        return FAILURE;
+    }
+
+    chunk->previous = arena.current;
+    chunk->capacity = capacity;
+
+    arena.current = chunk;
+    arena.base = (char*) chunk + CHUNK_HEADER_SIZE;
+    arena.capacity = capacity;
+    arena.top = 0;
+    arena.total += capacity;
+
+    return SUCCESS;
+}
+
+static void* arena_allocate(size_t size) {
+    size = align(size);
+
+    if ((arena.capacity - arena.top < size) && (arena_grow(size) == FAILURE)) {
+        return NULL;
+    }
+
+    void* ptr = arena.base + arena.top;
+    arena.top += size;
+
+    return ptr;
+}
+
+// Whether 'ptr', of 'size' bytes, is the most recent allocation in the
+// current chunk.
+static inline int arena_is_top(const void* ptr, size_t size) {
+    return (arena.base != NULL) && ((const char*) ptr + align(size) == arena.base + arena.top);
+}
+
+void arena_enter(void) {
+    arena.active = TRUE;
+}
+
+void arena_leave(void) {
+    arena.active = FALSE;
+    arena.top = 0;
+
+    // Keep only the largest chunk, which is the current one, so that the
+    // next scope fits in a single chunk.
+    struct chunk* chunk = arena.current ? arena.current->previous : NULL;
+
+    while (chunk) {
+        struct chunk* previous = chunk->previous;
+
+        free(chunk);
+        chunk = previous;
+    }
+
+    if (arena.current) {
+        arena.current->previous = NULL;
+    }
+
+    arena.total = arena.capacity;
+}
+
+int arena_suspend(void) {
+    int active = arena.active;
+
+    arena.active = FALSE;
+
+    return active;
+}
+
+void arena_resume(int active) {
+    arena.active = active;
+}
+
+void arena_free(void) {
+    arena_leave();
+
+    free(arena.current);
+
+    arena.current = NULL;
+    arena.base = NULL;
+    arena.capacity = 0;
+    arena.total = 0;
+}
+
+// GMP does not expect its memory functions to fail, just like its own.
+static void out_of_memory(size_t size) {
+    fprintf(stderr, "[Error] Failed to allocate %zu bytes\n", size);
+    abort();
+}
+
+static void* gmp_allocate(size_t size) {
+    void* ptr = NULL;
+
+    if (arena.active && (size <= ARENA_MAX_ALLOCATION)) {
+        ptr = arena_allocate(size);
+    }
+
+    if (thread_stats) {
+        ++thread_stats->allocations;
+        thread_stats->allocated_bytes += size;
+
+        if (ptr) {
+            ++thread_stats->arena_allocations;
+        }
+    }
+
+    if (ptr == NULL) {
+        ptr = malloc(size);
+
+        if (ptr == NULL) {
+            out_of_memory(size);
+        }
+    }
+
+    return ptr;
+}
+
+static void gmp_free(void* ptr, size_t size) {
+    if (thread_stats) {
+        ++thread_stats->frees;
+    }
+
+    if (!arena_owns(ptr)) {
+        free(ptr);
+        return;
+    }
+
+    if (arena_is_top(ptr, size)) {
+        arena.top = (size_t) ((char*) ptr - arena.base);
+    }
+}
+
+static void* gmp_reallocate(void* ptr, size_t old_size, size_t new_size) {
+    if (!arena_owns(ptr)) {
+        if (thread_stats) {
+            ++thread_stats->reallocations;
+
+            if (new_size > old_size) {
+                thread_stats->allocated_bytes += new_size - old_size;
+            }
+        }
+
+        void* grown = realloc(ptr, new_size);
+
+        if (grown == NULL) {
+            out_of_memory(new_size);
+        }
+
+        return grown;
+    }
+
+    // The most recent allocation can simply be resized in place, as long as
+    // the chunk has room for it.
+    if (arena_is_top(ptr, old_size)) {
+        size_t offset = (size_t) ((char*) ptr - arena.base);
+
+        if (arena.capacity - offset >= align(new_size)) {
+            if (thread_stats) {
+                ++thread_stats->reallocations;
+            }
+
+            arena.top = offset + align(new_size);
+            return ptr;
+        }
+    }
+
+    void* moved = gmp_allocate(new_size);
+
+    memcpy(moved, ptr, (old_size < new_size) ? old_size : new_size);
+    gmp_free(ptr, old_size);
+
+    return moved;
+}
+
+void memory_install(void) {
+    mp_set_memory_functions(gmp_allocate, gmp_reallocate, gmp_free);
+}
@@ -0,0 +1,196 @@
+
+#include "hex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                OUTPUT.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This file contains the output buffer. Every result line is
+ *          assembled in a single reusable buffer, which is written out with
+ *          as few system calls as possible, either when it fills up, or at
+ *          the end of every line if the output is line-buffered, as it is
+ *          when writing to a terminal.
+ *
+ *          An output with no file descriptor is kept entirely in memory,
+ *          and its buffer simply grows as needed.
+ *
+ *  **************************************************************************/
+
+int output_init(struct output* out, int fd, size_t capacity, int line_buffered) {
+    out->fd = fd;
+    out->size = 0;
+    out->capacity = (capacity > 0) ? capacity : OUTPUT_BUFFER_SIZE;
+    out->line_buffered = line_buffered;
+    out->error = FALSE;
+    out->buffer = malloc(out->capacity);
+
+    if (out->buffer == NULL) {
+        fprintf(stderr, "[Error] Failed to allocate %zu bytes for the output buffer\n", out->capacity);
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+void output_free(struct output* out) {
+    free(out->buffer);
+
+    out->buffer = NULL;
+    out->size = 0;
+    out->capacity = 0;
+}
+
+// Write every byte described by 'iov', retrying after interruptions and
+// partial writes.
+static int write_all(struct output* out, struct iovec* iov, int count) {
+    int previous = stats_stage(STAGE_OUTPUT);
+
+    while (count > 0) {
+        ssize_t written = writev(out->fd, iov, count);
+
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            fprintf(stderr, "[Error] Failed to write output (%s)\n", strerror(errno));
+            out->error = TRUE;
+            stats_stage(previous);
+            return FAILURE;
+        }
+
+        if (thread_stats) {
+            thread_stats->output_bytes += (uint64_t) written;
+        }
+
+        // Skip over the vectors written in full, and advance into the first
+        // one that was only written in part.
+        while ((count > 0) && ((size_t) written >= iov->iov_len)) {
+            written -= (ssize_t) iov->iov_len;
+            ++iov;
+            --count;
+        }
+
+        if (count > 0) {
+            iov->iov_base = (char*) iov->iov_base + written;
+            iov->iov_len -= (size_t) written;
+        }
+    }
+
+    stats_stage(previous);
+
+    return SUCCESS;
+}
+
+int output_flush(struct output* out) {
+    if ((out->fd == -1) || (out->size == 0)) {
+        return SUCCESS;
+    }
+
+    if (out->error) {
+        return FAILURE;
+    }
+
+    struct iovec iov = { out->buffer, out->size };
+
+    out->size = 0;
+
+    return write_all(out, &iov, 1);
+}
+
+// Grow an in-memory output until 'len' more bytes fit.
+static int output_grow(struct output* out, size_t len) {
+    size_t capacity = out->capacity;
+
+    while (capacity - out->size < len) {
+        capacity *= 2;
+    }
+
+    char* buffer = realloc(out->buffer, capacity);
+
+    if (buffer == NULL) {
+        fprintf(stderr, "[Error] Failed to grow the output buffer to %zu bytes\n", capacity);
+        out->error = TRUE;
+        return FAILURE;
+    }
+
+    out->buffer = buffer;
+    out->capacity = capacity;
+
+    return SUCCESS;
+}
+
+char* output_reserve(struct output* out, size_t len) {
+    if (out->capacity - out->size >= len) {
+        return out->buffer + out->size;
+    }
+
+    if (out->fd != -1) {
+        if (output_flush(out) == FAILURE) {
+            return NULL;
+        }
+
+        if (out->capacity >= len) {
+            return out->buffer;
+        }
+    }
+
+    if (output_grow(out, len) == FAILURE) {
+        return NULL;
+    }
+
+    return out->buffer + out->size;
+}
+
+int output_write(struct output* out, const void* data, size_t len) {
+    if (out->capacity - out->size >= len) {
+        memcpy(out->buffer + out->size, data, len);
+        out->size += len;
+        return SUCCESS;
+    }
+
+    if (out->fd == -1) {
+        if (output_grow(out, len) == FAILURE) {
+            return FAILURE;
+        }
+
+        memcpy(out->buffer + out->size, data, len);
+        out->size += len;
+        return SUCCESS;
+    }
+
+    if (out->error) {
+        return FAILURE;
+    }
+
+    // The data does not fit, so write whatever is buffered along with the
+    // data itself in a single call, without copying the data first.
+    struct iovec iov[2] = {
+        { out->buffer, out->size },
+        { (void*) data, len }
+    };
+
+    out->size = 0;
+
+    return write_all(out, iov, 2);
+}
+
+int output_end_line(struct output* out) {
+    if (output_putc(out, '\n') == FAILURE) {
+        return FAILURE;
+    }
+
+    if (out->line_buffered) {
+        return output_flush(out);
+    }
+
+    return out->error ? FAILURE : SUCCESS;
+}
@@ -0,0 +1,421 @@
+
+#include "hex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                PARALLEL.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This file contains the worker pool used to convert large streams
+ *          of inputs on multiple threads. The inputs are split into batches,
+ *          which are converted by the workers, each with its own converter,
+ *          into the batch's own in-memory output.
+ *
+ *          The batches live in a ring, and the thread submitting them also
+ *          acts as the sequencer: once the ring is full, it waits for the
+ *          oldest batch to finish, writes its results out, and reuses it.
+ *          Since the batches are always written out in the order they were
+ *          submitted, the results come out in the original input order.
+ *
+ *  **************************************************************************/
+
+// A batch is submitted as soon as it holds either this many inputs, or this
+// many bytes of copied input text.
+
+#ifndef BATCH_TOKENS
+#define BATCH_TOKENS 4096
+#endif // BATCH_TOKENS
+
+#ifndef BATCH_BYTES
+#define BATCH_BYTES (1 << 18)
+#endif // BATCH_BYTES
+
+// Number of batches in the ring per worker thread, so that the workers can
+// start on new batches while the sequencer waits for the oldest one.
+#define BATCHES_PER_THREAD 4
+
+enum { BATCH_FREE, BATCH_QUEUED, BATCH_DONE };
+
+struct batch {
+    const char** tokens;
+    size_t* lengths;
+    uint64_t* offsets;
+    size_t count;
+
+    // The inputs are numbered consecutively, following the number of inputs
+    // added before the first one.
+    uint64_t first_index;
+
+    // Inputs that may not outlive the call that adds them are copied here.
+    // The text is never reallocated while it holds any input, so the token
+    // pointers into it remain valid.
+    char* text;
+    size_t text_size;
+    size_t text_capacity;
+
+    struct output out;
+    int state;
+    int failed;
+    int invalid;
+
+    // Number of inputs rejected by the error policy, and of those too large
+    // for u64, and the reason and position of the invalid input that stopped
+    // the conversion, if any.
+    uint64_t rejected;
+    uint64_t rejected_range;
+    uint64_t invalid_index;
+    uint64_t invalid_offset;
+};
+
+struct worker {
+    struct pool* pool;
+    struct converter conv;
+    struct stats stats;
+    pthread_t thread;
+};
+
+static int batch_init(struct batch* batch) {
+    batch->count = 0;
+    batch->text_size = 0;
+    batch->text_capacity = BATCH_BYTES;
+    batch->state = BATCH_FREE;
+    batch->failed = FALSE;
+    batch->invalid = FALSE;
+    batch->rejected = 0;
+    batch->rejected_range = 0;
+
+    batch->tokens = malloc(BATCH_TOKENS * sizeof (const char*));
+    batch->lengths = malloc(BATCH_TOKENS * sizeof (size_t));
+    batch->offsets = malloc(BATCH_TOKENS * sizeof (uint64_t));
+    batch->text = malloc(batch->text_capacity);
+
+    if ((batch->tokens == NULL) || (batch->lengths == NULL) || (batch->offsets == NULL) || (batch->text == NULL)) {
+        fprintf(stderr, "[Error] Failed to allocate input batch\n");
+        return FAILURE;
+    }
+
+    return output_init(&batch->out, -1, 0, FALSE);
+}
+
+static void batch_free(struct batch* batch) {
+    free(batch->tokens);
+    free(batch->lengths);
+    free(batch->offsets);
+    free(batch->text);
+
+    output_free(&batch->out);
+}
+
+static void convert_batch(struct worker* worker, struct batch* batch) {
+    struct converter* conv = &worker->conv;
+
+    conv->out = &batch->out;
+
+    uint64_t rejected = conv->rejected;
+    uint64_t rejected_range = conv->rejected_range;
+
+    for (size_t i = 0; i < batch->count; ++i) {
+        if (convert_input(conv, batch->tokens[i], batch->lengths[i], batch->first_index + i + 1, batch->offsets[i]) == FAILURE) {
+            // The results up to the failed input are still written out, just
+            // as they are when converting serially, but nothing after it is.
+            batch->failed = TRUE;
+            batch->invalid = conv->invalid;
+            batch->invalid_index = conv->invalid_index;
+            batch->invalid_offset = conv->invalid_offset;
+            conv->invalid = FALSE;
+            break;
+        }
+    }
+
+    batch->rejected = conv->rejected - rejected;
+    batch->rejected_range = conv->rejected_range - rejected_range;
+}
+
+static void* worker_main(void* arg) {
+    struct worker* worker = arg;
+    struct pool* pool = worker->pool;
+
+    if (pool->collect_stats) {
+        stats_init(&worker->stats);
+        thread_stats = &worker->stats;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    for (;;) {
+        while ((pool->taken == pool->submitted) && !pool->stopping) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+
+        if (pool->taken == pool->submitted) {
+            break;
+        }
+
+        struct batch* batch = &pool->batches[pool->taken++ % pool->batch_count];
+
+        pthread_mutex_unlock(&pool->lock);
+        convert_batch(worker, batch);
+        pthread_mutex_lock(&pool->lock);
+
+        batch->state = BATCH_DONE;
+        pthread_cond_broadcast(&pool->work_done);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    arena_free();
+
+    return NULL;
+}
+
+size_t pool_default_threads(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (cpus > 0) ? (size_t) cpus : 1;
+}
+
+int pool_init(struct pool* pool, size_t threads, const struct converter* settings, struct output* out) {
+    pool->out = out;
+    pool->thread_count = 0;
+    pool->batch_count = threads * BATCHES_PER_THREAD;
+    pool->submitted = 0;
+    pool->taken = 0;
+    pool->written = 0;
+    pool->stopping = FALSE;
+    pool->failed = FALSE;
+    pool->tokens = 0;
+    pool->rejected = 0;
+    pool->rejected_range = 0;
+    pool->collect_stats = (thread_stats != NULL);
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+
+    pool->batches = calloc(pool->batch_count, sizeof (struct batch));
+    pool->workers = calloc(threads, sizeof (struct worker));
+
+    if ((pool->batches == NULL) || (pool->workers == NULL)) {
+        fprintf(stderr, "[Error] Failed to allocate worker pool\n");
+        pool_free(pool);
+        return FAILURE;
+    }
+
+    for (size_t i = 0; i < pool->batch_count; ++i) {
+        if (batch_init(&pool->batches[i]) == FAILURE) {
+            pool_free(pool);
+            return FAILURE;
+        }
+    }
+
+    // Every worker gets its own converter, with the same output settings as
+    // the one used when converting serially. The threads for parsing and
+    // printing giant numbers are split between the workers, rather than
+    // given to every one of them, so that no more threads than asked for
+    // ever run at once.
+    size_t worker_threads = (settings->threads > threads) ? settings->threads / threads : 1;
+
+    for (size_t i = 0; i < threads; ++i) {
+        struct worker* worker = &pool->workers[i];
+
+        worker->pool = pool;
+
+        converter_init(&worker->conv);
+        worker->conv.from = settings->from;
+        worker->conv.to = settings->to;
+        worker->conv.grouping = settings->grouping;
+        worker->conv.pretty_print = settings->pretty_print;
+        worker->conv.threads = worker_threads;
+        worker->conv.format = settings->format;
+        worker->conv.on_error = settings->on_error;
+
+        int error = pthread_create(&worker->thread, NULL, worker_main, worker);
+
+        if (error != 0) {
+            fprintf(stderr, "[Error] Failed to start worker thread (%s)\n", strerror(error));
+            converter_clear(&worker->conv);
+            pool_free(pool);
+            return FAILURE;
+        }
+
+        ++pool->thread_count;
+    }
+
+    pool->current = &pool->batches[0];
+
+    return SUCCESS;
+}
+
+// Wait for the oldest batch to finish, write its results out, and make it
+// available for reuse.
+static int pool_retire(struct pool* pool) {
+    struct batch* batch = &pool->batches[pool->written % pool->batch_count];
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (batch->state != BATCH_DONE) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    ++pool->written;
+
+    // Once a batch has failed, none of the results after it are written.
+    if (!pool->failed) {
+        pool->rejected += batch->rejected;
+        pool->rejected_range += batch->rejected_range;
+
+        if (output_write(pool->out, batch->out.buffer, batch->out.size) == FAILURE) {
+            pool->failed = TRUE;
+        } else if (pool->out->line_buffered && (output_flush(pool->out) == FAILURE)) {
+            pool->failed = TRUE;
+        }
+
+        if (batch->failed) {
+            if (batch->invalid) {
+                report_invalid_token(batch->invalid, batch->invalid_index, batch->invalid_offset);
+            }
+
+            pool->failed = TRUE;
+        }
+    }
+
+    batch->count = 0;
+    batch->text_size = 0;
+    batch->out.size = 0;
+    batch->failed = FALSE;
+    batch->invalid = FALSE;
+    batch->rejected = 0;
+    batch->rejected_range = 0;
+    batch->state = BATCH_FREE;
+
+    return pool->failed ? FAILURE : SUCCESS;
+}
+
+// Hand the current batch over to the workers, and get the next one ready,
+// retiring the batch previously in its slot first if it is still in use.
+static int pool_submit(struct pool* pool) {
+    if (pool->current->count == 0) {
+        return SUCCESS;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    pool->current->state = BATCH_QUEUED;
+    ++pool->submitted;
+
+    pthread_cond_signal(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    pool->current = &pool->batches[pool->submitted % pool->batch_count];
+
+    if (pool->submitted - pool->written == pool->batch_count) {
+        return pool_retire(pool);
+    }
+
+    return SUCCESS;
+}
+
+int pool_convert(struct pool* pool, const char* token, size_t len, uint64_t offset, int copy) {
+    if (pool->failed) {
+        return FAILURE;
+    }
+
+    struct batch* batch = pool->current;
+
+    if (copy) {
+        // Submit the batch if the text does not fit, and grow the text of
+        // the next batch if it would not fit even on its own.
+        if ((batch->text_capacity - batch->text_size < len) && (pool_submit(pool) == FAILURE)) {
+            return FAILURE;
+        }
+
+        batch = pool->current;
+
+        if (batch->text_capacity < len) {
+            char* text = realloc(batch->text, len);
+
+            if (text == NULL) {
+                fprintf(stderr, "[Error] Failed to allocate %zu bytes for input batch\n", len);
+                pool->failed = TRUE;
+                return FAILURE;
+            }
+
+            batch->text = text;
+            batch->text_capacity = len;
+        }
+
+        memcpy(batch->text + batch->text_size, token, len);
+        token = batch->text + batch->text_size;
+        batch->text_size += len;
+    }
+
+    if (batch->count == 0) {
+        batch->first_index = pool->tokens;
+    }
+
+    batch->tokens[batch->count] = token;
+    batch->lengths[batch->count] = len;
+    batch->offsets[batch->count] = offset;
+
+    ++pool->tokens;
+
+    if (++batch->count == BATCH_TOKENS) {
+        return pool_submit(pool);
+    }
+
+    return SUCCESS;
+}
+
+int pool_drain(struct pool* pool) {
+    // Even if submitting fails, every batch still in flight is retired, so
+    // that nothing refers to the inputs once this returns.
+    pool_submit(pool);
+
+    while (pool->written < pool->submitted) {
+        pool_retire(pool);
+    }
+
+    return pool->failed ? FAILURE : SUCCESS;
+}
+
+void pool_free(struct pool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = TRUE;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->thread_count; ++i) {
+        pthread_join(pool->workers[i].thread, NULL);
+        converter_clear(&pool->workers[i].conv);
+
+        if (pool->collect_stats) {
+            stats_merge(thread_stats, &pool->workers[i].stats);
+        }
+    }
+
+    if (pool->batches) {
+        for (size_t i = 0; i < pool->batch_count; ++i) {
+            batch_free(&pool->batches[i]);
+        }
+    }
+
+    free(pool->batches);
+    free(pool->workers);
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_cond_destroy(&pool->work_done);
+
+    pool->batches = NULL;
+    pool->workers = NULL;
+    pool->thread_count = 0;
+}
@@ -0,0 +1,346 @@
+
+#include "hex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                PARSE.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This file contains the conversion engine proper. Rather than
+ *          building up the value one hexadecimal digit at a time with a
+ *          multiply and an add per character, which makes the conversion
+ *          quadratic in the length of the input, the digits are validated
+ *          in a single forward pass and then packed directly into the GMP
+ *          limbs of the output number, which is linear.
+ *
+ *          Numbers small enough to fit in a native integer bypass GMP
+ *          entirely, since they make up the vast majority of inputs.
+ *
+ *          Numbers in other bases get the same treatment: the digits of
+ *          every power of two are packed into the limbs just the same, and
+ *          the digits of any other base are accumulated a whole chunk at a
+ *          time, rather than a single digit at a time.
+ *
+ *  **************************************************************************/
+
+// Every hexadecimal digit encodes exactly four bits, so a limb holds a fixed
+// number of digits and the value of each limb can be computed independently
+// of all the others.
+#define HEX_DIGITS_PER_LIMB (GMP_NUMB_BITS / 4)
+
+// Number of limbs decoded per call to the decoding kernel. The packed bytes
+// for the whole block are kept on the stack.
+#define LIMBS_PER_BLOCK 64
+
+// Minimum number of digits decoded by each thread when a single number is
+// decoded on multiple threads.
+
+#ifndef PARALLEL_PARSE_DIGITS
+#define PARALLEL_PARSE_DIGITS (1 << 18)
+#endif // PARALLEL_PARSE_DIGITS
+
+// Assemble a limb from big-endian packed bytes.
+static inline mp_limb_t load_limb(const unsigned char* bytes) {
+    mp_limb_t value = 0;
+
+    for (size_t i = 0; i < sizeof (mp_limb_t); ++i) {
+        value = (value << 8) | bytes[i];
+    }
+
+    return value;
+}
+
+int hex_span(const char* str, size_t len, size_t* start, size_t* end, size_t* invalid_offset) {
+    *start = 0;
+
+    // Skip the '0x' or '0X' prefix, but only at the very start of the input.
+    // A leading zero not followed by an 'x' is simply a leading zero, and it
+    // is handled like any other digit.
+    if ((len >= 2) && (str[0] == '0') && ((str[1] == 'x') || (str[1] == 'X'))) {
+        *start = 2;
+    }
+
+    // Find the end of the digits while validating them. The 'h' or 'H' suffix
+    // marks the end of the number, and anything following it is ignored, just
+    // as anything other than a valid hex digit before it is an error.
+    *end = *start + hex_kernel()->scan(str + *start, len - *start);
+
+    if ((*end < len) && (str[*end] != 'h') && (str[*end] != 'H')) {
+        if (invalid_offset) {
+            *invalid_offset = *end;
+        }
+
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+fast_uint hex_to_uint(const char* digits, size_t count) {
+    fast_uint value = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        value = (value << 4) | (fast_uint) hex_value(digits[i]);
+    }
+
+    return value;
+}
+
+// Decode the full limbs in the range ['first', 'last'), where limb 'i' holds
+// the digits ending 'i' limbs before 'end'.
+static void decode_limbs(const struct hex_kernel* kernel, mp_limb_t* limb, const char* end, size_t first, size_t last) {
+    unsigned char bytes[LIMBS_PER_BLOCK * sizeof (mp_limb_t)];
+
+    const char* p = end - first * HEX_DIGITS_PER_LIMB;
+
+    for (size_t i = first; i < last; ) {
+        size_t block = last - i;
+
+        if (block > LIMBS_PER_BLOCK) {
+            block = LIMBS_PER_BLOCK;
+        }
+
+        p -= block * HEX_DIGITS_PER_LIMB;
+        kernel->decode(p, block * HEX_DIGITS_PER_LIMB, bytes);
+
+        // The packed bytes are in big-endian order, so the last limb of the
+        // block is the least significant one.
+        for (size_t j = 0; j < block; ++j) {
+            limb[i + j] = load_limb(bytes + (block - 1 - j) * sizeof (mp_limb_t));
+        }
+
+        i += block;
+    }
+}
+
+// Decode the most significant limb, which may be partially full, one digit
+// at a time.
+static mp_limb_t decode_leading_limb(const char* digits, size_t count) {
+    mp_limb_t value = 0;
+
+    for (size_t j = 0; j < count; ++j) {
+        value = (value << 4) | (mp_limb_t) hex_value(digits[j]);
+    }
+
+    return value;
+}
+
+void hex_to_mpz(mpz_t n, const char* digits, size_t count) {
+    if (count == 0) {
+        mpz_set_ui(n, 0);
+        return;
+    }
+
+    // Write the limbs directly, starting from the least significant digit at
+    // the end of the string. Every full limb is decoded by the kernel in
+    // blocks, and the most significant limb is decoded on its own. If the
+    // partial limb is zero or there are leading zeros, 'mpz_limbs_finish'
+    // takes care of normalizing the number.
+    size_t full_limbs = count / HEX_DIGITS_PER_LIMB;
+    size_t leading_digits = count % HEX_DIGITS_PER_LIMB;
+
+    mp_size_t limbs = (mp_size_t) (full_limbs + (leading_digits ? 1 : 0));
+    mp_limb_t* limb = mpz_limbs_write(n, limbs);
+
+    decode_limbs(hex_kernel(), limb, digits + count, 0, full_limbs);
+
+    if (leading_digits) {
+        limb[full_limbs] = decode_leading_limb(digits, leading_digits);
+    }
+
+    mpz_limbs_finish(n, limbs);
+}
+
+// A range of limbs decoded by a single thread.
+struct segment {
+    const struct hex_kernel* kernel;
+    mp_limb_t* limb;
+    const char* end;
+    size_t first;
+    size_t last;
+    pthread_t thread;
+    int started;
+};
+
+static void* decode_segment(void* arg) {
+    struct segment* segment = arg;
+
+    decode_limbs(segment->kernel, segment->limb, segment->end, segment->first, segment->last);
+
+    return NULL;
+}
+
+void hex_to_mpz_parallel(mpz_t n, const char* digits, size_t count, size_t threads) {
+    // Every thread gets at least PARALLEL_PARSE_DIGITS digits, since starting
+    // a thread is not free, and decoding is already very fast.
+    if (threads > count / PARALLEL_PARSE_DIGITS) {
+        threads = count / PARALLEL_PARSE_DIGITS;
+    }
+
+    struct segment* segments = (threads > 1) ? malloc(threads * sizeof (struct segment)) : NULL;
+
+    if (segments == NULL) {
+        hex_to_mpz(n, digits, count);
+        return;
+    }
+
+    // Every limb only depends on its own digits, so the full limbs are split
+    // into one contiguous range per thread, and every thread writes its range
+    // of limbs directly into the number. There is nothing to put together
+    // afterwards.
+    const struct hex_kernel* kernel = hex_kernel();
+
+    size_t full_limbs = count / HEX_DIGITS_PER_LIMB;
+    size_t leading_digits = count % HEX_DIGITS_PER_LIMB;
+
+    mp_size_t limbs = (mp_size_t) (full_limbs + (leading_digits ? 1 : 0));
+    mp_limb_t* limb = mpz_limbs_write(n, limbs);
+
+    for (size_t t = 0; t < threads; ++t) {
+        segments[t].kernel = kernel;
+        segments[t].limb = limb;
+        segments[t].end = digits + count;
+        segments[t].first = full_limbs * t / threads;
+        segments[t].last = full_limbs * (t + 1) / threads;
+        segments[t].started = (t > 0) && (pthread_create(&segments[t].thread, NULL, decode_segment, &segments[t]) == 0);
+    }
+
+    // The first segment is decoded by this thread, as is any segment for
+    // which a thread could not be started.
+    for (size_t t = 0; t < threads; ++t) {
+        if (segments[t].started) {
+            continue;
+        }
+
+        decode_segment(&segments[t]);
+    }
+
+    for (size_t t = 1; t < threads; ++t) {
+        if (segments[t].started) {
+            pthread_join(segments[t].thread, NULL);
+        }
+    }
+
+    if (leading_digits) {
+        limb[full_limbs] = decode_leading_limb(digits, leading_digits);
+    }
+
+    mpz_limbs_finish(n, limbs);
+
+    free(segments);
+}
+
+// Accumulate up to a chunk of digits in a base that is not a power of two.
+static inline uint64_t accumulate_chunk(int radix, const char* digits, size_t count) {
+    uint64_t value = 0;
+
+    for (size_t j = 0; j < count; ++j) {
+        value = value * (uint64_t) radix + (uint64_t) digit_value(digits[j]);
+    }
+
+    return value;
+}
+
+fast_uint digits_to_uint(const struct base* base, const char* digits, size_t count) {
+    fast_uint value = 0;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    // The digits of a power of two are simply packed together, with no
+    // multiplication at all.
+    if (base->bits) {
+        for (size_t i = 0; i < count; ++i) {
+            value = (value << base->bits) | (fast_uint) digit_value(digits[i]);
+        }
+
+        return value;
+    }
+
+    // Otherwise, the digits are accumulated in 64-bit chunks, so that there
+    // is only a single wide multiplication per chunk, rather than one per
+    // digit. The first chunk holds the digits left over from full chunks.
+    size_t first = (count - 1) % (size_t) base->chunk_digits + 1;
+
+    value = accumulate_chunk(base->radix, digits, first);
+
+    for (size_t i = first; i < count; i += (size_t) base->chunk_digits) {
+        value = value * base->chunk_base + accumulate_chunk(base->radix, digits + i, (size_t) base->chunk_digits);
+    }
+
+    return value;
+}
+
+void digits_to_mpz(mpz_t n, const struct base* base, const char* digits, size_t count) {
+    if (count == 0) {
+        mpz_set_ui(n, 0);
+        return;
+    }
+
+    if (base->bits) {
+        // Every digit of a power of two encodes a fixed number of bits, so
+        // the digits are packed directly into the limbs, starting from the
+        // least significant digit at the end of the string. Since the digits
+        // may straddle two limbs when the number of bits does not divide the
+        // size of a limb, the bits that do not fit are carried over.
+        mp_size_t limbs = (mp_size_t) ((count * (size_t) base->bits + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS);
+        mp_limb_t* limb = mpz_limbs_write(n, limbs);
+
+        mp_limb_t value = 0;
+        unsigned used = 0;
+        size_t i = 0;
+
+        for (const char* p = digits + count; p > digits; ) {
+            mp_limb_t digit = (mp_limb_t) digit_value(*--p);
+
+            value |= digit << used;
+            used += (unsigned) base->bits;
+
+            if (used >= GMP_NUMB_BITS) {
+                limb[i++] = value;
+                used -= GMP_NUMB_BITS;
+                value = used ? digit >> (base->bits - (int) used) : 0;
+            }
+        }
+
+        if (used > 0) {
+            limb[i] = value;
+        }
+
+        mpz_limbs_finish(n, limbs);
+        return;
+    }
+
+    // Any other base goes through GMP's own conversion, which takes the
+    // values of the digits, rather than the characters, and accumulates them
+    // a full limb at a time, switching to a subquadratic algorithm for giant
+    // numbers. The values are a temporary like any other, so they come from
+    // the arena while converting a number.
+    void* (*allocate)(size_t);
+    void (*release)(void*, size_t);
+
+    mp_get_memory_functions(&allocate, NULL, &release);
+
+    unsigned char* values = allocate(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = (unsigned char) digit_value(digits[i]);
+    }
+
+    // The number needs at most a limb for every chunk of digits, along with
+    // the extra limb GMP requires.
+    mp_size_t limbs = (mp_size_t) ((count / (size_t) base->chunk_digits + 1) * (64 / GMP_NUMB_BITS) + 1);
+    mp_limb_t* limb = mpz_limbs_write(n, limbs);
+
+    mpz_limbs_finish(n, (mp_size_t) mpn_set_str(limb, values, count, base->radix));
+
+    release(values, count);
+}
@@ -0,0 +1,194 @@
+
+#include "hex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                SCAN.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This file contains the scanning mode, which copies arbitrary text
+ *          to the output, such as log files, converting the hexadecimal
+ *          numbers embedded in it along the way. Every number is either
+ *          replaced by its value, or followed by it, and every other byte is
+ *          written out exactly as it was read.
+ *
+ *          A number is a whole word with the '0x' prefix, or with the 'h'
+ *          suffix and a leading decimal digit, so that ordinary words such
+ *          as "each" are never mistaken for numbers. Words are made up of
+ *          letters, digits, and underscores, so "0x1f," and "[0x1f]" are
+ *          numbers, but "0x1fg" and "id_0x1f" are not.
+ *
+ *          Since every number has either an 'x' or an 'h' in it, the text
+ *          is searched for those letters many bytes at a time, and only the
+ *          words around them are ever looked at. The text in between is
+ *          written out in bulk, straight from the input buffer.
+ *
+ *  **************************************************************************/
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#define SCAN_SSE2 1
+#include <emmintrin.h>
+#endif // __GNUC__ && __SSE2__
+
+static inline int is_word(char c) {
+    unsigned char u = (unsigned char) c;
+
+    return ((unsigned) ((u | 0x20) - 'a') < 26) || ((unsigned) (u - '0') < 10) || (u == '_');
+}
+
+// Find the first 'x' or 'h', in either case, in the range ['i', 'end') of
+// the text, or return 'end' if there is none. Setting the 0x20 bit turns the
+// uppercase letters into lowercase, and no other byte into either letter.
+static size_t find_marker(const char* text, size_t i, size_t end) {
+    #if defined(SCAN_SSE2)
+    const __m128i lowercase = _mm_set1_epi8(0x20);
+    const __m128i x = _mm_set1_epi8('x');
+    const __m128i h = _mm_set1_epi8('h');
+
+    for ( ; i + 16 <= end; i += 16) {
+        __m128i chunk = _mm_or_si128(_mm_loadu_si128((const __m128i*) (text + i)), lowercase);
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, x), _mm_cmpeq_epi8(chunk, h)));
+
+        if (mask) {
+            return i + (size_t) __builtin_ctz((unsigned) mask);
+        }
+    }
+    #endif // SCAN_SSE2
+
+    for ( ; i < end; ++i) {
+        char c = (char) (text[i] | 0x20);
+
+        if ((c == 'x') || (c == 'h')) {
+            return i;
+        }
+    }
+
+    return end;
+}
+
+// Whether the word of length 'len' is a number, following the same rules as
+// the inputs, along with the prefix or suffix that sets it apart from other
+// words. The digits are the range ['start', 'end') of the word.
+static int is_number(const char* word, size_t len, size_t* start, size_t* end) {
+    if ((hex_span(word, len, start, end, NULL) == FAILURE) || (*end == *start)) {
+        return FALSE;
+    }
+
+    // Anything after the suffix makes it some other word.
+    if (*end + 1 < len) {
+        return FALSE;
+    }
+
+    if (*start == 2) {
+        return TRUE;
+    }
+
+    return (*end < len) && (word[0] >= '0') && (word[0] <= '9');
+}
+
+// Scan the text in the range ['start', 'limit'), which never ends in the
+// middle of a word, and write it out along with the values of the numbers.
+static int scan_text(struct converter* conv, const char* text, size_t start, size_t limit, int mode) {
+    struct output* out = conv->out;
+
+    size_t written = start;
+    size_t i = start;
+
+    while ((i = find_marker(text, i, limit)) < limit) {
+        // Every number is a whole word, so only the word around the marker
+        // needs to be looked at.
+        size_t first = i;
+        size_t last = i + 1;
+
+        while ((first > start) && is_word(text[first - 1])) {
+            --first;
+        }
+
+        while ((last < limit) && is_word(text[last])) {
+            ++last;
+        }
+
+        size_t digits_start;
+        size_t digits_end;
+
+        if (is_number(text + first, last - first, &digits_start, &digits_end)) {
+            if (thread_stats) {
+                stats_input(thread_stats, last - first);
+            }
+
+            size_t keep = (mode == SCAN_APPEND) ? last : first;
+
+            if ((output_write(out, text + written, keep - written) == FAILURE)
+                || ((mode == SCAN_APPEND) && (output_write(out, " (", 2) == FAILURE))
+                || (convert_value(conv, text + first + digits_start, digits_end - digits_start) == FAILURE)
+                || ((mode == SCAN_APPEND) && (output_putc(out, ')') == FAILURE))) {
+                return FAILURE;
+            }
+
+            written = last;
+        }
+
+        i = last;
+    }
+
+    return output_write(out, text + written, limit - written);
+}
+
+int scan_file(struct converter* conv, const char* path, int mode) {
+    struct input in;
+
+    int previous = stats_stage(STAGE_INPUT);
+    int result = input_open(&in, path);
+
+    if (result == FAILURE) {
+        stats_stage(previous);
+        return FAILURE;
+    }
+
+    while (result == SUCCESS) {
+        // Unless this is the end of the input, the last word in the buffer
+        // may continue in the next chunk, so it is kept for the next round.
+        // A word that fills the whole buffer makes it grow instead.
+        size_t limit = in.end;
+
+        if (!in.eof) {
+            while ((limit > in.start) && is_word(in.buffer[limit - 1])) {
+                --limit;
+            }
+        }
+
+        if (limit > in.start) {
+            stats_stage(STAGE_DECODE);
+            result = scan_text(conv, in.buffer, in.start, limit, mode);
+            stats_stage(STAGE_INPUT);
+
+            in.start = limit;
+
+            // There is no telling where the lines end without looking for
+            // them, so the output is flushed after every chunk of input,
+            // which is every line when reading from a terminal.
+            if ((result == SUCCESS) && conv->out->line_buffered) {
+                result = output_flush(conv->out);
+            }
+        }
+
+        if ((result == FAILURE) || in.eof) {
+            break;
+        }
+
+        result = input_fill(&in);
+    }
+
+    input_close(&in);
+
+    stats_stage(previous);
+
+    return result;
+}
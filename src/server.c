@@ -0,0 +1,351 @@
+
+#include "hex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                SERVER.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This file contains the server mode, in which the program stays
+ *          alive and converts batches of numbers on request, either over
+ *          standard input and output, as a coprocess, or over the connections
+ *          to a Unix domain socket. The converter, along with the locale
+ *          information, is set up once and reused for every request.
+ *
+ *          Every integer in the protocol is an unsigned 32-bit integer in
+ *          little-endian byte order. A request is the number of inputs,
+ *          followed by the length and the characters of each one:
+ *
+ *              count, (length, characters) * count
+ *
+ *          The response has the same number of results, each of which is a
+ *          status byte, zero for success or one for an invalid input, and
+ *          the length and characters of the value in the output base, which
+ *          is decimal unless the server was started with '--to', and which
+ *          are empty for invalid inputs:
+ *
+ *              count, (status, length, characters) * count
+ *
+ *          When pretty-printing, the decimal values are grouped, but the
+ *          inputs are not repeated in the results.
+ *
+ *  **************************************************************************/
+
+// Largest input accepted, in bytes. A client sending more than this is
+// disconnected, rather than trusted with that much memory.
+
+#ifndef SERVER_MAX_INPUT
+#define SERVER_MAX_INPUT (1U << 30)
+#endif // SERVER_MAX_INPUT
+
+// Number of pending connections to a socket before new ones are refused.
+#define SERVER_BACKLOG 16
+
+// Set by SIGINT or SIGTERM while serving a socket, to stop the server once
+// the request in progress, if any, has been answered.
+static volatile sig_atomic_t stopping = 0;
+
+static void stop_serving(int signum) {
+    (void) signum;
+
+    stopping = 1;
+}
+
+// Read exactly 'len' bytes. If the peer closes the connection before the
+// first byte, that is the end of the requests, and not an error, and so is
+// the server being stopped while waiting for it.
+static int read_exact(int fd, void* data, size_t len, int* closed) {
+    size_t total = 0;
+
+    *closed = FALSE;
+
+    while (total < len) {
+        ssize_t bytes = read(fd, (char*) data + total, len - total);
+
+        if (bytes == -1) {
+            if ((errno == EINTR) && stopping && (total == 0)) {
+                *closed = TRUE;
+                return FAILURE;
+            }
+
+            if (errno == EINTR) {
+                continue;
+            }
+
+            fprintf(stderr, "[Error] Failed to read request (%s)\n", strerror(errno));
+            return FAILURE;
+        }
+
+        if (bytes == 0) {
+            if (total == 0) {
+                *closed = TRUE;
+            } else {
+                fprintf(stderr, "[Error] Truncated request\n");
+            }
+
+            return FAILURE;
+        }
+
+        total += (size_t) bytes;
+    }
+
+    return SUCCESS;
+}
+
+// Read the next input of a request into 'buffer', which only ever grows, up
+// to SERVER_MAX_INPUT bytes.
+static int read_input(int fd, char** buffer, size_t* capacity, size_t* len) {
+    unsigned char header[4];
+    int closed;
+
+    if (read_exact(fd, header, sizeof header, &closed) == FAILURE) {
+        if (closed) {
+            fprintf(stderr, "[Error] Truncated request\n");
+        }
+
+        return FAILURE;
+    }
+
+    *len = (uint32_t) load_le(header, 4);
+
+    if (*len > SERVER_MAX_INPUT) {
+        fprintf(stderr, "[Error] Input too large: %zu bytes\n", *len);
+        return FAILURE;
+    }
+
+    if (*len > *capacity) {
+        char* grown = realloc(*buffer, *len);
+
+        if (grown == NULL) {
+            fprintf(stderr, "[Error] Failed to allocate %zu bytes for the input\n", *len);
+            return FAILURE;
+        }
+
+        *buffer = grown;
+        *capacity = *len;
+    }
+
+    if ((*len > 0) && (read_exact(fd, *buffer, *len, &closed) == FAILURE)) {
+        if (closed) {
+            fprintf(stderr, "[Error] Truncated request\n");
+        }
+
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+// Convert a single input into 'scratch', and write out its result. The
+// result is converted first so that its length is known before it is
+// written.
+static int serve_input(struct converter* conv, const char* token, size_t len, struct output* out, struct output* scratch) {
+    unsigned char header[5];
+    size_t start;
+    size_t end;
+
+    scratch->size = 0;
+
+    // Every input is counted in the statistics just as it is when converting
+    // files, invalid inputs included.
+    int previous = stats_stage(STAGE_DECODE);
+
+    if (thread_stats) {
+        stats_input(thread_stats, len);
+    }
+
+    if (digit_span(conv->from, token, len, &start, &end, NULL) == FAILURE) {
+        if (thread_stats) {
+            ++thread_stats->invalid;
+        }
+
+        header[0] = 1;
+    } else {
+        stats_stage(STAGE_FORMAT);
+
+        if (convert_value(conv, token + start, end - start) == FAILURE) {
+            stats_stage(previous);
+            return FAILURE;
+        }
+
+        header[0] = 0;
+    }
+
+    stats_stage(previous);
+
+    if (scratch->error || (scratch->size > UINT32_MAX)) {
+        return FAILURE;
+    }
+
+    store_le(header + 1, (uint32_t) scratch->size, 4);
+
+    if (output_write(out, header, sizeof header) == FAILURE) {
+        return FAILURE;
+    }
+
+    return output_write(out, scratch->buffer, scratch->size);
+}
+
+int serve_stream(struct converter* conv, int in_fd, int out_fd) {
+    struct output out;
+    struct output scratch;
+
+    // The response is assembled in memory, and only written out once the
+    // whole request has been read, since a client may well write an entire
+    // request before it starts reading the response.
+    if (output_init(&out, -1, 0, FALSE) == FAILURE) {
+        return FAILURE;
+    }
+
+    if (output_init(&scratch, -1, 0, FALSE) == FAILURE) {
+        output_free(&out);
+        return FAILURE;
+    }
+
+    // The converter writes every result into the scratch output, and it is
+    // only restored once the stream ends.
+    struct output* previous = conv->out;
+    conv->out = &scratch;
+
+    char* buffer = NULL;
+    size_t capacity = 0;
+    int result = SUCCESS;
+
+    while (result == SUCCESS) {
+        unsigned char header[4];
+        int closed;
+
+        if (read_exact(in_fd, header, sizeof header, &closed) == FAILURE) {
+            // Closing the stream between requests is how the client says
+            // it is done.
+            if (!closed) {
+                result = FAILURE;
+            }
+
+            break;
+        }
+
+        // Since the number of results is the number of inputs, the response
+        // can be assembled as the inputs are read, and only the input being
+        // converted is kept in memory.
+        uint32_t count = (uint32_t) load_le(header, 4);
+
+        result = output_write(&out, header, sizeof header);
+
+        for (uint32_t i = 0; (i < count) && (result == SUCCESS); ++i) {
+            size_t len;
+
+            result = read_input(in_fd, &buffer, &capacity, &len);
+
+            if (result == SUCCESS) {
+                result = serve_input(conv, buffer, len, &out, &scratch);
+            }
+        }
+
+        // Every response is written out as soon as it is complete, in as
+        // few writes as possible.
+        if (result == SUCCESS) {
+            out.fd = out_fd;
+            result = output_flush(&out);
+            out.fd = -1;
+        }
+    }
+
+    free(buffer);
+
+    conv->out = previous;
+
+    output_free(&scratch);
+    output_free(&out);
+
+    return result;
+}
+
+int serve_socket(struct converter* conv, const char* path) {
+    struct sockaddr_un address;
+
+    if (strlen(path) >= sizeof address.sun_path) {
+        fprintf(stderr, "[Error] Socket path too long: %s\n", path);
+        return FAILURE;
+    }
+
+    memset(&address, 0, sizeof address);
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd == -1) {
+        fprintf(stderr, "[Error] Could not create socket (%s)\n", strerror(errno));
+        return FAILURE;
+    }
+
+    // A socket left behind by a previous server is replaced, but nothing
+    // else at that path ever is.
+    struct stat st;
+
+    if ((lstat(path, &st) == 0) && S_ISSOCK(st.st_mode)) {
+        unlink(path);
+    }
+
+    if ((bind(fd, (struct sockaddr*) &address, sizeof address) == -1) || (listen(fd, SERVER_BACKLOG) == -1)) {
+        fprintf(stderr, "[Error] Could not listen on socket: %s (%s)\n", path, strerror(errno));
+        close(fd);
+        return FAILURE;
+    }
+
+    // A client disconnecting in the middle of a response must only end its
+    // own connection, rather than the whole server.
+    signal(SIGPIPE, SIG_IGN);
+
+    // SIGINT and SIGTERM stop the server cleanly, removing the socket. The
+    // handler does not restart system calls, so that a blocked 'accept' or
+    // 'read' returns as soon as the signal arrives.
+    struct sigaction action;
+    struct sigaction previous_int;
+    struct sigaction previous_term;
+
+    memset(&action, 0, sizeof action);
+    action.sa_handler = stop_serving;
+    sigemptyset(&action.sa_mask);
+
+    stopping = 0;
+    sigaction(SIGINT, &action, &previous_int);
+    sigaction(SIGTERM, &action, &previous_term);
+
+    int result = SUCCESS;
+
+    // Connections are served one at a time, each until the client closes
+    // it. A failed connection is simply closed.
+    while (!stopping) {
+        int connection = accept(fd, NULL, NULL);
+
+        if (connection == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            fprintf(stderr, "[Error] Could not accept connection (%s)\n", strerror(errno));
+            result = FAILURE;
+            break;
+        }
+
+        serve_stream(conv, connection, connection);
+        close(connection);
+    }
+
+    sigaction(SIGINT, &previous_int, NULL);
+    sigaction(SIGTERM, &previous_term, NULL);
+
+    close(fd);
+    unlink(path);
+
+    return result;
+}
@@ -0,0 +1,155 @@
+
+#include "hex2dec.h"
+
+/** ***************************************************************************
+ *
+ *                                STATS.C
+ *
+ *  ***************************************************************************
+ *
+ *      Author:     Jose Fernando Lopez Fernandez
+ *
+ *      Date:       18 October, 2026
+ *
+ *      Description:
+ *
+ *          This file contains the instrumentation behind the '--stats'
+ *          option. Every thread doing any work has its own statistics, which
+ *          are merged together once the thread is done, so the counters are
+ *          never shared between threads while they are being updated.
+ *
+ *          The time spent in each stage of the pipeline is measured with a
+ *          single clock reading whenever the thread switches from one stage
+ *          to another, so the time is attributed to exactly one stage, even
+ *          when the stages are nested, as writing the output is within
+ *          formatting the digits.
+ *
+ *          When the statistics are not enabled, every probe is a single
+ *          check of a thread-local pointer. GMP's allocations are counted by
+ *          the memory functions in memory.c.
+ *
+ *  **************************************************************************/
+
+_Thread_local struct stats* thread_stats = NULL;
+
+static const char* const stage_names[STAGE_COUNT] = {
+    "other",
+    "input",
+    "decode",
+    "convert",
+    "format",
+    "output"
+};
+
+uint64_t stats_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * UINT64_C(1000000000) + (uint64_t) ts.tv_nsec;
+}
+
+void stats_init(struct stats* stats) {
+    memset(stats, 0, sizeof (struct stats));
+
+    stats->stage = STAGE_OTHER;
+    stats->last = stats_now();
+}
+
+int stats_switch(struct stats* stats, int stage) {
+    uint64_t now = stats_now();
+    int previous = stats->stage;
+
+    stats->time[previous] += now - stats->last;
+    stats->last = now;
+    stats->stage = stage;
+
+    return previous;
+}
+
+void stats_merge(struct stats* into, const struct stats* from) {
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        into->time[i] += from->time[i];
+    }
+
+    for (int i = 0; i < STATS_HISTOGRAM_BUCKETS; ++i) {
+        into->lengths[i] += from->lengths[i];
+    }
+
+    into->inputs += from->inputs;
+    into->invalid += from->invalid;
+    into->fast_path += from->fast_path;
+    into->input_bytes += from->input_bytes;
+    into->output_bytes += from->output_bytes;
+    into->allocations += from->allocations;
+    into->arena_allocations += from->arena_allocations;
+    into->reallocations += from->reallocations;
+    into->frees += from->frees;
+    into->allocated_bytes += from->allocated_bytes;
+}
+
+void stats_input(struct stats* stats, size_t len) {
+    // Inputs are counted in buckets by the position of the highest bit of
+    // their length, so bucket 'i' holds the lengths from 2^i to 2^(i+1) - 1,
+    // except for bucket zero, which also holds empty inputs.
+    int bucket = 0;
+
+    while ((bucket < STATS_HISTOGRAM_BUCKETS - 1) && (len >> (bucket + 1))) {
+        ++bucket;
+    }
+
+    ++stats->inputs;
+    ++stats->lengths[bucket];
+    stats->input_bytes += len;
+}
+
+void stats_report(const struct stats* stats, uint64_t elapsed, FILE* stream) {
+    double seconds = (double) elapsed / 1e9;
+
+    // The stages are timed on every thread, so their total may exceed the
+    // elapsed time. Time spent outside of any stage, such as waiting for
+    // other threads, is not reported.
+    uint64_t busy = 0;
+
+    for (int i = STAGE_OTHER + 1; i < STAGE_COUNT; ++i) {
+        busy += stats->time[i];
+    }
+
+    fprintf(stream, "Statistics:\n");
+    fprintf(stream, "    Elapsed time:      %.6f s\n", seconds);
+    fprintf(stream, "    Inputs:            %" PRIu64 " (%" PRIu64 " invalid, %" PRIu64 " without GMP)\n",
+            stats->inputs, stats->invalid, stats->fast_path);
+    fprintf(stream, "    Input bytes:       %" PRIu64 "\n", stats->input_bytes);
+    fprintf(stream, "    Output bytes:      %" PRIu64 "\n", stats->output_bytes);
+
+    if (seconds > 0) {
+        fprintf(stream, "    Throughput:        %.1f inputs/s, %.1f input bytes/s\n",
+                (double) stats->inputs / seconds, (double) stats->input_bytes / seconds);
+    }
+
+    fprintf(stream, "\n    Stage times (total over all threads):\n");
+
+    for (int i = STAGE_OTHER + 1; i < STAGE_COUNT; ++i) {
+        fprintf(stream, "        %-10s %12.6f s %6.1f%%\n", stage_names[i], (double) stats->time[i] / 1e9,
+                busy ? 100.0 * (double) stats->time[i] / (double) busy : 0.0);
+    }
+
+    fprintf(stream, "\n    Input lengths:\n");
+
+    for (int i = 0; i < STATS_HISTOGRAM_BUCKETS; ++i) {
+        if (stats->lengths[i] == 0) {
+            continue;
+        }
+
+        uint64_t low = (i == 0) ? 0 : (UINT64_C(1) << i);
+        uint64_t high = (UINT64_C(1) << i << 1) - 1;
+
+        fprintf(stream, "        %10" PRIu64 " - %-10" PRIu64 " %12" PRIu64 "\n", low, high, stats->lengths[i]);
+    }
+
+    fprintf(stream, "\n    GMP memory:\n");
+    fprintf(stream, "        allocations    %12" PRIu64 " (%" PRIu64 " from the arena)\n", stats->allocations, stats->arena_allocations);
+    fprintf(stream, "        reallocations  %12" PRIu64 "\n", stats->reallocations);
+    fprintf(stream, "        frees          %12" PRIu64 "\n", stats->frees);
+    fprintf(stream, "        bytes          %12" PRIu64 "\n", stats->allocated_bytes);
+}